@@ -10,30 +10,243 @@ UI_Cell uiCell;
 UI_Power uiPower;
 UI_Player uiPlayer;
 
-void UI_Board::renderBoard(SDL_Renderer* renderer, int** playerBoard, int rowAmount, int colAmount) {
+UI_Board::UI_Board()
+    : boardLayer(nullptr), layerRows(0), layerCols(0), layerVersion(0), cacheUnavailable(false),
+      minimap(nullptr), minimapScale(0), minimapRows(0), minimapCols(0), minimapVersion(0) {}
+
+// Textures are owned by the renderer, so this must run before it is destroyed
+void UI_Board::releaseTextures() {
+    if (boardLayer) SDL_DestroyTexture(boardLayer);
+    if (minimap) SDL_DestroyTexture(minimap);
+    boardLayer = nullptr;
+    minimap = nullptr;
+    layerRows = 0;
+    layerCols = 0;
+}
+
+// Render target contents are lost on SDL_RENDER_TARGETS_RESET / SDL_RENDER_DEVICE_RESET
+void UI_Board::invalidate() {
+    releaseTextures();
+    cacheUnavailable = false;
+}
+
+// Cell codes as drawn: 1-2 players, 3-5 powers, 6 portal, 7 treasure
+int UI_Board::cellContents(nodeMatrix& matrix, const Player& player1, const Player& player2, int row, int col) const {
+    pair<int, int> cell(row, col);
+    if (player1.getCurrentPosition() == cell) return 1;
+    if (player2.getCurrentPosition() == cell) return 2;
+    uint8_t features = matrix.getFeatures(row, col);
+    if (features & CELL_TREASURE) return 7;
+    if (features & CELL_PORTAL) return 6;
+    if (features & CELL_POWER) {
+        switch (matrix.getPowerAt(row, col)) {
+            case PowerType::DOUBLE_PLAY: return 3;
+            case PowerType::CONTROL_ENEMY: return 4;
+            case PowerType::JUMP_WALL: return 5;
+            default: break;
+        }
+    }
+    return 0;
+}
+
+void UI_Board::renderContents(int row, int col, int num) {
+    if (num >= 3 && num <= 7) { // Double Turn, Mind Control, Jump Wall, Portal, Treasure
+        uiPower.renderPower(batch, row, col, num);
+    }
+    else if (num == 1 || num == 2) { // Players
+        uiPlayer.renderPlayer(batch, row, col, num);
+    }
+}
+
+void UI_Board::renderFullCell(nodeMatrix& matrix, int row, int col, int num) {
+    uiCell.renderCell(batch, row, col);
+    uiCell.renderWalls(batch, row, col, matrix.hasWall(row, col, Direction::UP), matrix.hasWall(row, col, Direction::RIGHT),
+                       matrix.hasWall(row, col, Direction::DOWN), matrix.hasWall(row, col, Direction::LEFT));
+    renderContents(row, col, num);
+}
+
+// Creates the board texture for boards small enough to cache whole. Every
+// cell is marked dirty when the size or the maze changes, so the next frame
+// redraws all of it.
+bool UI_Board::prepareLayer(SDL_Renderer* renderer, nodeMatrix& matrix) {
+    int rowAmount = matrix.getRows();
+    int colAmount = matrix.getColumns();
+    int width = colAmount * CELL_SIZE;
+    int height = rowAmount * CELL_SIZE;
+    if (width > BOARD_LAYER_MAX_PIXELS || height > BOARD_LAYER_MAX_PIXELS) return false;
+
+    if (!boardLayer || layerRows != rowAmount || layerCols != colAmount) {
+        if (boardLayer) SDL_DestroyTexture(boardLayer);
+        boardLayer = nullptr;
+
+        SDL_RendererInfo info;
+        if (!SDL_RenderTargetSupported(renderer) || SDL_GetRendererInfo(renderer, &info) != 0 ||
+            (info.max_texture_width && width > info.max_texture_width) ||
+            (info.max_texture_height && height > info.max_texture_height)) {
+            cacheUnavailable = true;
+            return false;
+        }
+        boardLayer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+        if (!boardLayer) {
+            cerr << "Unable to create board layer! SDL Error: " << SDL_GetError() << endl;
+            cacheUnavailable = true;
+            return false;
+        }
+        SDL_SetTextureScaleMode(boardLayer, SDL_ScaleModeLinear);
+        layerRows = rowAmount;
+        layerCols = colAmount;
+        layerVersion = matrix.getTopologyVersion() + 1;
+    }
+    if (layerVersion != matrix.getTopologyVersion()) {
+        layerVersion = matrix.getTopologyVersion();
+        lastBoard.assign(static_cast<size_t>(rowAmount) * colAmount, -1);
+    }
+    return true;
+}
+
+// Patches the cells whose contents changed with one batch into the layer,
+// then copies the layer through the camera; the GPU clips it to the window
+void UI_Board::renderLayer(SDL_Renderer* renderer, nodeMatrix& matrix, const Player& player1, const Player& player2, const UI_Camera& camera) {
+    batch.setTransform(0, 0, 1);
+    batch.clear();
+    for (int i = 0; i < layerRows; i++) {
+        for (int j = 0; j < layerCols; j++) {
+            int num = cellContents(matrix, player1, player2, i, j);
+            int& last = lastBoard[static_cast<size_t>(i) * layerCols + j];
+            if (last == num) continue;
+            last = num;
+            renderFullCell(matrix, i, j, num);
+        }
+    }
+    if (!batch.empty()) {
+        SDL_SetRenderTarget(renderer, boardLayer);
+        batch.flush(renderer);
+        SDL_SetRenderTarget(renderer, nullptr);
+    }
+
+    float cellPixels = camera.getCellPixels();
+    SDL_FRect board = {camera.toScreenX(0), camera.toScreenY(0), layerCols * cellPixels, layerRows * cellPixels};
+    SDL_RenderCopyF(renderer, boardLayer, nullptr, &board);
+}
+
+// Large boards: only cells that intersect the window are drawn, so the cost
+// depends on the zoom, never on the board size
+void UI_Board::renderVisibleCells(SDL_Renderer* renderer, nodeMatrix& matrix, const Player& player1, const Player& player2, const UI_Camera& camera) {
+    int firstRow, firstCol, lastRow, lastCol;
+    camera.visibleCells(firstRow, firstCol, lastRow, lastCol);
+
+    batch.clear();
+    batch.setTransform(camera.toScreenX(0), camera.toScreenY(0), camera.getCellPixels() / CELL_SIZE);
+    for (int i = firstRow; i <= lastRow; i++) {
+        for (int j = firstCol; j <= lastCol; j++) {
+            renderFullCell(matrix, i, j, cellContents(matrix, player1, player2, i, j));
+        }
+    }
+    batch.flush(renderer);
+    batch.setTransform(0, 0, 1);
+}
+
+// Builds the level-of-detail texture: with scale 2 every cell becomes a
+// 2x2 block (cell, east wall, south wall, corner post), which keeps the maze
+// readable; boards too big for that get one pixel per cell, shaded by how
+// many walls the cell has. Rebuilt only when the maze changes.
+bool UI_Board::prepareMinimap(SDL_Renderer* renderer, nodeMatrix& matrix) {
+    int rowAmount = matrix.getRows();
+    int colAmount = matrix.getColumns();
+    if (minimap && minimapRows == rowAmount && minimapCols == colAmount && minimapVersion == matrix.getTopologyVersion()) {
+        return true;
+    }
+
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer, &info) != 0) return false;
+    int maxWidth = info.max_texture_width ? info.max_texture_width : 1 << 30;
+    int maxHeight = info.max_texture_height ? info.max_texture_height : 1 << 30;
+    int scale = 2 * colAmount <= maxWidth && 2 * rowAmount <= maxHeight ? 2 : 1;
+    if (colAmount > maxWidth || rowAmount > maxHeight) return false;
+
+    const Uint32 open = 0xFFFFFFFF;
+    const Uint32 wall = 0xFF1E1E1E;
+    int width = colAmount * scale;
+    minimapPixels.assign(static_cast<size_t>(width) * rowAmount * scale, wall);
     for (int i = 0; i < rowAmount; i++) {
-       for (int j = 0; j < colAmount; j++) {
-            uiCell.renderCell(renderer, i, j);
-            if (playerBoard[i][j] == 3) { // Double Turn
-                uiPower.renderPower(renderer, i, j, 3);
-            }
-            else if (playerBoard[i][j] == 4) { // Mind Control
-                uiPower.renderPower(renderer, i, j, 4);
-            }
-            else if (playerBoard[i][j] == 5) { // Jump Wall
-                uiPower.renderPower(renderer, i, j, 5);
-            }
-            else if (playerBoard[i][j] == 6) { // Portal
-                uiPower.renderPower(renderer, i, j, 6);
+        Uint32* top = &minimapPixels[static_cast<size_t>(i) * scale * width];
+        for (int j = 0; j < colAmount; j++) {
+            bool east = matrix.hasWall(i, j, Direction::RIGHT);
+            bool south = matrix.hasWall(i, j, Direction::DOWN);
+            if (scale == 2) {
+                top[2 * j] = open;
+                top[2 * j + 1] = east ? wall : open;
+                top[width + 2 * j] = south ? wall : open;
+            } else {
+                int walls = east + south + matrix.hasWall(i, j, Direction::UP) + matrix.hasWall(i, j, Direction::LEFT);
+                Uint32 shade = 255 - 45 * walls;
+                top[j] = 0xFF000000 | shade << 16 | shade << 8 | shade;
             }
-            else if (playerBoard[i][j] == 7) { // Treasure
-                uiPower.renderPower(renderer, i, j, 7);
-            }
-            else if (playerBoard[i][j] == 1 || playerBoard[i][j] == 2) { // Players (may move it to UI_Board)
-                uiPlayer.renderPlayer(renderer, i, j, playerBoard[i][j]);
-            }
-        } 
+        }
     }
 
-    SDL_RenderPresent(renderer);
-}
\ No newline at end of file
+    if (!minimap || minimapRows != rowAmount || minimapCols != colAmount || minimapScale != scale) {
+        if (minimap) SDL_DestroyTexture(minimap);
+        minimap = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, width, rowAmount * scale);
+        if (!minimap) {
+            cerr << "Unable to create minimap! SDL Error: " << SDL_GetError() << endl;
+            return false;
+        }
+    }
+    SDL_UpdateTexture(minimap, nullptr, minimapPixels.data(), width * 4);
+    minimapScale = scale;
+    minimapRows = rowAmount;
+    minimapCols = colAmount;
+    minimapVersion = matrix.getTopologyVersion();
+    return true;
+}
+
+// Zoomed out: one textured copy for the maze, then the players and features
+// as markers never smaller than MARKER_MIN_PIXELS, in one batch
+void UI_Board::renderMinimap(SDL_Renderer* renderer, nodeMatrix& matrix, const Player& player1, const Player& player2, const UI_Camera& camera) {
+    float cellPixels = camera.getCellPixels();
+    float left = camera.toScreenX(0);
+    float top = camera.toScreenY(0);
+    SDL_FRect board = {left, top, minimapCols * cellPixels, minimapRows * cellPixels};
+    SDL_SetTextureScaleMode(minimap, cellPixels >= minimapScale ? SDL_ScaleModeNearest : SDL_ScaleModeLinear);
+    SDL_RenderCopyF(renderer, minimap, nullptr, &board);
+
+    float scale = cellPixels / CELL_SIZE;
+    float size = max(static_cast<float>(CELL_SIZE), MARKER_MIN_PIXELS / scale);
+    batch.clear();
+    batch.setTransform(left, top, scale);
+    auto marker = [&](const pair<int, int>& position, int num) {
+        if (!matrix.isInside(position.first, position.second)) return;
+        float centerX = (position.second + 0.5f) * CELL_SIZE;
+        float centerY = (position.first + 0.5f) * CELL_SIZE;
+        batch.addSprite(SDL_FRect{centerX - size / 2, centerY - size / 2, size, size}, num);
+    };
+    auto feature = [&](const pair<int, int>& position) {
+        if (!matrix.isInside(position.first, position.second)) return;
+        int num = cellContents(matrix, player1, player2, position.first, position.second);
+        if (num >= 3) marker(position, num);
+    };
+    feature(matrix.getTreasure().getPosition());
+    for (const Portal& portal : matrix.getPortals()) {
+        feature(portal.getPortalAPosition());
+        feature(portal.getPortalBPosition());
+    }
+    for (const Power& power : matrix.getPowers()) {
+        if (power.isPowerPresent()) feature(power.getPosition());
+    }
+    marker(player1.getCurrentPosition(), 1);
+    marker(player2.getCurrentPosition(), 2);
+    batch.flush(renderer);
+    batch.setTransform(0, 0, 1);
+}
+
+// Draws the board into the current frame without presenting it
+void UI_Board::renderBoard(SDL_Renderer* renderer, nodeMatrix& matrix, const Player& player1, const Player& player2, const UI_Camera& camera) {
+    if (camera.getCellPixels() < LOD_CELL_PIXELS && prepareMinimap(renderer, matrix)) {
+        renderMinimap(renderer, matrix, player1, player2, camera);
+    } else if (!cacheUnavailable && prepareLayer(renderer, matrix)) {
+        renderLayer(renderer, matrix, player1, player2, camera);
+    } else {
+        renderVisibleCells(renderer, matrix, player1, player2, camera);
+    }
+}
@@ -3,11 +3,50 @@
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
+#include <vector>
+#include "UI_Camera.h"
+#include "UI_SpriteBatch.h"
+#include "backend.h"
+const int BOARD_LAYER_MAX_PIXELS = 4096;  // Boards up to 40x40 cells are cached whole in one texture
+const float LOD_CELL_PIXELS = 12.0f;      // Smaller cells are drawn from the minimap texture
+const float MARKER_MIN_PIXELS = 6.0f;     // Players and features stay visible when zoomed out
 using namespace std;
 
+// Draws the board through a camera, one of three ways:
+//  - zoomed out below LOD_CELL_PIXELS: the cached minimap texture plus markers
+//  - small boards: a cached texture of the whole board, patched per dirty cell
+//  - large boards: only the cells that intersect the window, as one batch
 class UI_Board {
 public:
-    void renderBoard(SDL_Renderer* renderer, int** playerBoard, int rowAmount, int colAmount);
+    UI_Board();
+    void renderBoard(SDL_Renderer* renderer, nodeMatrix& matrix, const Player& player1, const Player& player2, const UI_Camera& camera);
+    void invalidate();
+    void releaseTextures();
+
+private:
+    int cellContents(nodeMatrix& matrix, const Player& player1, const Player& player2, int row, int col) const;
+    void renderFullCell(nodeMatrix& matrix, int row, int col, int num);
+    void renderContents(int row, int col, int num);
+    bool prepareLayer(SDL_Renderer* renderer, nodeMatrix& matrix);
+    void renderLayer(SDL_Renderer* renderer, nodeMatrix& matrix, const Player& player1, const Player& player2, const UI_Camera& camera);
+    void renderVisibleCells(SDL_Renderer* renderer, nodeMatrix& matrix, const Player& player1, const Player& player2, const UI_Camera& camera);
+    bool prepareMinimap(SDL_Renderer* renderer, nodeMatrix& matrix);
+    void renderMinimap(SDL_Renderer* renderer, nodeMatrix& matrix, const Player& player1, const Player& player2, const UI_Camera& camera);
+
+    UI_SpriteBatch batch;      // Reused every frame, so its buffers stop growing after the first
+    SDL_Texture* boardLayer;   // The whole board, patched per dirty cell
+    vector<int> lastBoard;     // Contents of boardLayer, -1 when the cell must be redrawn
+    int layerRows;
+    int layerCols;
+    Uint64 layerVersion;       // nodeMatrix topology the layer was drawn for
+    bool cacheUnavailable;     // No render targets or no memory for the layer
+
+    SDL_Texture* minimap;      // minimapScale pixels per cell edge: cell, east wall, south wall, corner
+    int minimapScale;
+    int minimapRows;
+    int minimapCols;
+    Uint64 minimapVersion;
+    vector<Uint32> minimapPixels;
 };
 
-#endif
\ No newline at end of file
+#endif
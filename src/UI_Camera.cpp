@@ -0,0 +1,140 @@
+#include "UI_Camera.h"
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+UI_Camera::UI_Camera()
+    : centerRow(0), centerCol(0), cellPixels(100), viewWidth(1), viewHeight(1),
+      boardRows(1), boardCols(1), followRow(0), followCol(0), following(true), dragging(false) {}
+
+void UI_Camera::setViewport(int width, int height) {
+    viewWidth = max(1, width);
+    viewHeight = max(1, height);
+    clampCenter();
+}
+
+void UI_Camera::setBoardSize(int rows, int cols) {
+    boardRows = max(1, rows);
+    boardCols = max(1, cols);
+    clampCenter();
+}
+
+// Shows the whole board; following stops so the view stays put
+void UI_Camera::fitBoard() {
+    float fit = min(static_cast<float>(viewWidth) / boardCols, static_cast<float>(viewHeight) / boardRows);
+    cellPixels = min(CAMERA_MAX_CELL_PIXELS, max(CAMERA_MIN_CELL_PIXELS, fit));
+    centerRow = boardRows / 2.0f;
+    centerCol = boardCols / 2.0f;
+    following = false;
+}
+
+void UI_Camera::follow(int row, int col) {
+    followRow = row;
+    followCol = col;
+    if (!following) return;
+    centerRow = row + 0.5f;
+    centerCol = col + 0.5f;
+    clampCenter();
+}
+
+// Moves the view by a number of window pixels
+void UI_Camera::pan(float dx, float dy) {
+    following = false;
+    centerCol -= dx / cellPixels;
+    centerRow -= dy / cellPixels;
+    clampCenter();
+}
+
+// Zooms while keeping the board point under (screenX, screenY) in place
+void UI_Camera::zoomAt(float factor, int screenX, int screenY) {
+    float anchorCol = centerCol + (screenX - viewWidth / 2.0f) / cellPixels;
+    float anchorRow = centerRow + (screenY - viewHeight / 2.0f) / cellPixels;
+    cellPixels = min(CAMERA_MAX_CELL_PIXELS, max(CAMERA_MIN_CELL_PIXELS, cellPixels * factor));
+    if (!following) {
+        centerCol = anchorCol - (screenX - viewWidth / 2.0f) / cellPixels;
+        centerRow = anchorRow - (screenY - viewHeight / 2.0f) / cellPixels;
+    }
+    clampCenter();
+}
+
+// Mouse wheel zooms, dragging with the right or middle button pans,
+// +/- zoom on the view centre, 0 fits the board and F follows the player
+// again. Returns true when the view changed.
+bool UI_Camera::handleEvent(const SDL_Event& event) {
+    switch (event.type) {
+        case SDL_MOUSEWHEEL: {
+            int x, y;
+            SDL_GetMouseState(&x, &y);
+            if (event.wheel.y == 0) return false;
+            zoomAt(event.wheel.y > 0 ? CAMERA_ZOOM_STEP : 1 / CAMERA_ZOOM_STEP, x, y);
+            return true;
+        }
+        case SDL_MOUSEBUTTONDOWN:
+            if (event.button.button == SDL_BUTTON_LEFT) return false;
+            dragging = true;
+            return false;
+        case SDL_MOUSEBUTTONUP:
+            dragging = false;
+            return false;
+        case SDL_MOUSEMOTION:
+            if (!dragging) return false;
+            pan(static_cast<float>(event.motion.xrel), static_cast<float>(event.motion.yrel));
+            return true;
+        case SDL_KEYDOWN:
+            switch (event.key.keysym.sym) {
+                case SDLK_EQUALS: case SDLK_PLUS: case SDLK_KP_PLUS:
+                    zoomAt(CAMERA_ZOOM_STEP, viewWidth / 2, viewHeight / 2);
+                    return true;
+                case SDLK_MINUS: case SDLK_KP_MINUS:
+                    zoomAt(1 / CAMERA_ZOOM_STEP, viewWidth / 2, viewHeight / 2);
+                    return true;
+                case SDLK_0:
+                    fitBoard();
+                    return true;
+                case SDLK_f:
+                    setFollowing(true);
+                    return true;
+                default:
+                    return false;
+            }
+        default:
+            return false;
+    }
+}
+
+void UI_Camera::setFollowing(bool value) {
+    following = value;
+    follow(followRow, followCol);
+}
+
+bool UI_Camera::isFollowing() const {
+    return following;
+}
+
+float UI_Camera::getCellPixels() const {
+    return cellPixels;
+}
+
+float UI_Camera::toScreenX(float col) const {
+    return (col - centerCol) * cellPixels + viewWidth / 2.0f;
+}
+
+float UI_Camera::toScreenY(float row) const {
+    return (row - centerRow) * cellPixels + viewHeight / 2.0f;
+}
+
+// Range of cells that intersect the window, clamped to the board
+void UI_Camera::visibleCells(int& firstRow, int& firstCol, int& lastRow, int& lastCol) const {
+    float halfCols = viewWidth / 2.0f / cellPixels;
+    float halfRows = viewHeight / 2.0f / cellPixels;
+    firstCol = max(0, static_cast<int>(floor(centerCol - halfCols)));
+    firstRow = max(0, static_cast<int>(floor(centerRow - halfRows)));
+    lastCol = min(boardCols - 1, static_cast<int>(floor(centerCol + halfCols)));
+    lastRow = min(boardRows - 1, static_cast<int>(floor(centerRow + halfRows)));
+}
+
+// The board may not leave the window completely
+void UI_Camera::clampCenter() {
+    centerRow = min(static_cast<float>(boardRows), max(0.0f, centerRow));
+    centerCol = min(static_cast<float>(boardCols), max(0.0f, centerCol));
+}
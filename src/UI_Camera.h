@@ -0,0 +1,46 @@
+#ifndef UI_CAMERA_H
+#define UI_CAMERA_H
+
+#include <SDL2/SDL.h>
+const float CAMERA_MIN_CELL_PIXELS = 0.1f;   // Zoom-out limit, on-screen size of one cell
+const float CAMERA_MAX_CELL_PIXELS = 200.0f; // Zoom-in limit
+const float CAMERA_ZOOM_STEP = 1.25f;
+using namespace std;
+
+// Maps board cells to window pixels. The view is centred on a point in cell
+// units and shows cellPixels pixels per cell. It follows the active player
+// until the view is panned, and F turns following back on.
+class UI_Camera {
+public:
+    UI_Camera();
+    void setViewport(int width, int height);
+    void setBoardSize(int rows, int cols);
+    void fitBoard();
+    void follow(int row, int col);
+    void pan(float dx, float dy);
+    void zoomAt(float factor, int screenX, int screenY);
+    bool handleEvent(const SDL_Event& event);
+    void setFollowing(bool value);
+    bool isFollowing() const;
+    float getCellPixels() const;
+    float toScreenX(float col) const;
+    float toScreenY(float row) const;
+    void visibleCells(int& firstRow, int& firstCol, int& lastRow, int& lastCol) const;
+
+private:
+    void clampCenter();
+
+    float centerRow;
+    float centerCol;
+    float cellPixels;
+    int viewWidth;
+    int viewHeight;
+    int boardRows;
+    int boardCols;
+    int followRow;
+    int followCol;
+    bool following;
+    bool dragging;
+};
+
+#endif
@@ -10,23 +10,32 @@ UI_Cell::~UI_Cell() {
     SDL_Quit();
 }
 
-void UI_Cell::renderCell(SDL_Renderer* renderer, int row, int col) { // Añadir 'int num' a los argumentos si existe una imagen para la celda
-    SDL_Color borderColor = {0, 0, 0, 255};
+void UI_Cell::renderCell(UI_SpriteBatch& batch, int row, int col) { // Añadir 'int num' a los argumentos si existe una imagen para la celda
+    SDL_Color borderColor = {200, 200, 200, 255}; // Light grid; walls are drawn dark on top
     SDL_Color fillColor = {255, 255, 255, 255};
 
     SDL_Rect cell = {col * CELL_SIZE, row * CELL_SIZE, CELL_SIZE, CELL_SIZE};
             
-    SDL_SetRenderDrawColor(renderer, borderColor.r, borderColor.g, borderColor.b, borderColor.a);
-    SDL_RenderFillRect(renderer, &cell);
+    batch.addRect(cell, borderColor);
             
     SDL_Rect innerCell = {col * CELL_SIZE + BORDER_WIDTH, row * CELL_SIZE + BORDER_WIDTH, 
                           CELL_SIZE - 2 * BORDER_WIDTH, CELL_SIZE - 2 * BORDER_WIDTH};
-    SDL_SetRenderDrawColor(renderer, fillColor.r, fillColor.g, fillColor.b, fillColor.a);
-    SDL_RenderFillRect(renderer, &innerCell);
+    batch.addRect(innerCell, fillColor);
             
-    // if (!imageLoader.textures.empty()) { 
-        // SDL_RenderCopy(renderer, imageLoader.textures[num], nullptr, &innerCell);
+    // if (imageLoader.atlas) { 
+        // batch.addSprite(innerCell, num);
     // }
+}
+
+// Each cell draws its half of every wall around it, staying inside its own
+// square, so a single cell can be redrawn without touching its neighbours
+void UI_Cell::renderWalls(UI_SpriteBatch& batch, int row, int col, bool up, bool right, bool down, bool left) {
+    SDL_Color wallColor = {30, 30, 30, 255};
+    int x = col * CELL_SIZE;
+    int y = row * CELL_SIZE;
 
-    SDL_RenderPresent(renderer);
+    if (up) batch.addRect(SDL_Rect{x, y, CELL_SIZE, WALL_WIDTH}, wallColor);
+    if (down) batch.addRect(SDL_Rect{x, y + CELL_SIZE - WALL_WIDTH, CELL_SIZE, WALL_WIDTH}, wallColor);
+    if (left) batch.addRect(SDL_Rect{x, y, WALL_WIDTH, CELL_SIZE}, wallColor);
+    if (right) batch.addRect(SDL_Rect{x + CELL_SIZE - WALL_WIDTH, y, WALL_WIDTH, CELL_SIZE}, wallColor);
 }
\ No newline at end of file
@@ -3,15 +3,18 @@
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
+#include "UI_SpriteBatch.h"
 const int CELL_SIZE = 100;
 #define BORDER_WIDTH 2
+#define WALL_WIDTH 5 // Drawn on each side of a shared wall, so walls look 10 px thick
 using namespace std;
 
 class UI_Cell {
 public:
     UI_Cell();
     ~UI_Cell();
-    void renderCell(SDL_Renderer* renderer, int row, int col);
+    void renderCell(UI_SpriteBatch& batch, int row, int col);
+    void renderWalls(UI_SpriteBatch& batch, int row, int col, bool up, bool right, bool down, bool left);
 
 private:
     SDL_Texture* texture;
@@ -1,9 +1,17 @@
 #include "UI_ImageLoader.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <thread>
 using namespace std;
 
 UI_ImageLoader imageLoader;
 
+UI_ImageLoader::UI_ImageLoader() : atlas(nullptr), whiteUV({0, 0, 0, 0}) {}
+
 void UI_ImageLoader::generatePathsForVector() {
     imagePaths.push_back("ui files/titlebg.png"); // Position in vector: 0
     imagePaths.push_back("ui files/player1.png"); // Position in vector: 1
@@ -16,20 +24,300 @@ void UI_ImageLoader::generatePathsForVector() {
     imagePaths.push_back("ui files/winscreen.png"); // Position in vector: 8
 }
 
+// Title and win screens fill the window and stay separate textures
+bool UI_ImageLoader::isBackground(int index) {
+    return index == 0 || index == 8;
+}
+
+// Box-filters src down into a size x size block of the RGBA32 atlas at
+// (x, y), weighting colour by alpha so transparent edges do not darken
+static void shrinkInto(SDL_Surface* src, SDL_Surface* atlas, int x, int y, int size) {
+    const Uint8* srcPixels = static_cast<const Uint8*>(src->pixels);
+    Uint8* dstPixels = static_cast<Uint8*>(atlas->pixels);
+    for (int dy = 0; dy < size; dy++) {
+        int y0 = dy * src->h / size;
+        int y1 = max(y0 + 1, (dy + 1) * src->h / size);
+        for (int dx = 0; dx < size; dx++) {
+            int x0 = dx * src->w / size;
+            int x1 = max(x0 + 1, (dx + 1) * src->w / size);
+            Uint64 r = 0, g = 0, b = 0, a = 0;
+            for (int sy = y0; sy < y1; sy++) {
+                const Uint8* p = srcPixels + sy * src->pitch + x0 * 4;
+                for (int sx = x0; sx < x1; sx++, p += 4) {
+                    r += p[0] * p[3];
+                    g += p[1] * p[3];
+                    b += p[2] * p[3];
+                    a += p[3];
+                }
+            }
+            Uint8* out = dstPixels + (y + dy) * atlas->pitch + (x + dx) * 4;
+            Uint64 count = static_cast<Uint64>(x1 - x0) * (y1 - y0);
+            out[0] = a ? static_cast<Uint8>(r / a) : 0;
+            out[1] = a ? static_cast<Uint8>(g / a) : 0;
+            out[2] = a ? static_cast<Uint8>(b / a) : 0;
+            out[3] = static_cast<Uint8>(a / count);
+        }
+    }
+}
+
+// Copies the outermost pixels of the block at (x, y) into its gutter
+static void fillGutter(SDL_Surface* atlas, int x, int y, int size) {
+    Uint32* pixels = static_cast<Uint32*>(atlas->pixels);
+    int stride = atlas->pitch / 4;
+    for (int row = y - ATLAS_GUTTER; row < y + size + ATLAS_GUTTER; row++) {
+        int srcRow = min(max(row, y), y + size - 1);
+        for (int col = x - ATLAS_GUTTER; col < x + size + ATLAS_GUTTER; col++) {
+            int srcCol = min(max(col, x), x + size - 1);
+            pixels[row * stride + col] = pixels[srcRow * stride + srcCol];
+        }
+    }
+}
+
+// Decodes every image (on worker threads, or straight out of the bundle)
+// and then uploads them on the calling thread, which must own the renderer.
+// A missing or broken image is reported and skipped instead of aborting
+// the rest: its texture stays nullptr and its atlas slot stays empty.
 bool UI_ImageLoader::loadImages(SDL_Renderer* renderer, const vector<string>& paths) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    vector<SDL_Surface*> images(paths.size(), nullptr);
+    bool fromBundle = mapBundle(paths, ASSET_BUNDLE_PATH, images);
+    bool loaded = fromBundle || decodeImages(paths, images);
+    Uint64 decoded = SDL_GetPerformanceCounter();
+
+    loaded = uploadImages(renderer, images) && loaded;
+    for (auto image : images) {
+        if (image) SDL_FreeSurface(image);
+    }
+    bundle.close();
+
+    double ticksPerMs = SDL_GetPerformanceFrequency() / 1000.0;
+    cout << "Loaded " << paths.size() << " images from " << (fromBundle ? "the bundle" : "PNG files")
+         << " in " << (SDL_GetPerformanceCounter() - start) / ticksPerMs << " ms ("
+         << (decoded - start) / ticksPerMs << " ms before upload)" << endl;
+    return loaded;
+}
+
+// Loads one image as RGBA32. Sprites come back already shrunk into an
+// ATLAS_SLOT_SIZE square with their gutter filled, ready to be copied into
+// the atlas. Runs on worker threads.
+SDL_Surface* UI_ImageLoader::prepareImage(const string& path, int index) {
+    SDL_Surface* loadedSurface = IMG_Load(path.c_str());
+    if (!loadedSurface) {
+        cerr << "Unable to load image " << path << "! SDL_image Error: " << IMG_GetError() << endl;
+        return nullptr;
+    }
+    SDL_Surface* converted = SDL_ConvertSurfaceFormat(loadedSurface, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(loadedSurface);
+    if (!converted) {
+        cerr << "Unable to convert " << path << "! SDL Error: " << SDL_GetError() << endl;
+        return nullptr;
+    }
+    if (isBackground(index)) return converted;
+
+    SDL_Surface* slot = SDL_CreateRGBSurfaceWithFormat(0, ATLAS_SLOT_SIZE, ATLAS_SLOT_SIZE, 32, SDL_PIXELFORMAT_RGBA32);
+    if (slot) {
+        shrinkInto(converted, slot, ATLAS_GUTTER, ATLAS_GUTTER, ATLAS_SPRITE_SIZE);
+        fillGutter(slot, ATLAS_GUTTER, ATLAS_GUTTER, ATLAS_SPRITE_SIZE);
+    } else {
+        cerr << "Unable to shrink " << path << "! SDL Error: " << SDL_GetError() << endl;
+    }
+    SDL_FreeSurface(converted);
+    return slot;
+}
+
+// Decoding is independent per image, so the images are handed out to one
+// thread per core; IMG_Load and the shrinking dominate startup
+bool UI_ImageLoader::decodeImages(const vector<string>& paths, vector<SDL_Surface*>& images) {
+    atomic<size_t> nextImage(0);
+    auto worker = [&]() {
+        for (size_t i = nextImage++; i < paths.size(); i = nextImage++) {
+            images[i] = prepareImage(paths[i], static_cast<int>(i));
+        }
+    };
+    size_t threadCount = min<size_t>(paths.size(), max(1u, thread::hardware_concurrency()));
+    vector<thread> workers;
+    for (size_t t = 1; t < threadCount; t++) workers.emplace_back(worker);
+    worker();
+    for (auto& w : workers) w.join();
+
+    return all_of(images.begin(), images.end(), [](SDL_Surface* image) { return image != nullptr; });
+}
+
+// Points the images at the pixels of a memory-mapped bundle. The bundle is
+// used only if it lists exactly these paths and is newer than every one of
+// them; otherwise the PNGs are decoded as usual.
+bool UI_ImageLoader::mapBundle(const vector<string>& paths, const string& bundlePath, vector<SDL_Surface*>& images) {
+    error_code error;
+    auto bundleTime = filesystem::last_write_time(bundlePath, error);
+    if (error) return false;
     for (const auto& path : paths) {
-        SDL_Surface* loadedSurface = IMG_Load(path.c_str());
-        if (!loadedSurface) {
-            cerr << "Unable to load image " << path << "! SDL_image Error: " << IMG_GetError() << endl;
+        auto imageTime = filesystem::last_write_time(path, error);
+        if (!error && imageTime > bundleTime) {
+            cout << "Asset bundle is older than " << path << ", decoding PNG files" << endl;
             return false;
         }
-        SDL_Texture* newTexture = SDL_CreateTextureFromSurface(renderer, loadedSurface);
-        SDL_FreeSurface(loadedSurface);
-        if (!newTexture) {
-            cerr << "Unable to create texture from " << path << "! SDL Error: " << SDL_GetError() << endl;
-            return false;
+    }
+    if (!bundle.open(bundlePath)) return false;
+
+    const unsigned char* data = bundle.data();
+    size_t size = bundle.size();
+    AssetBundleHeader header;
+    bool valid = size >= sizeof(header);
+    if (valid) {
+        memcpy(&header, data, sizeof(header));
+        valid = !memcmp(header.magic, "MZBUNDLE", 8) && header.version == ASSET_BUNDLE_VERSION &&
+                header.imageCount == paths.size() &&
+                size >= sizeof(header) + paths.size() * sizeof(AssetBundleEntry);
+    }
+    for (size_t i = 0; valid && i < paths.size(); i++) {
+        AssetBundleEntry entry;
+        memcpy(&entry, data + sizeof(header) + i * sizeof(entry), sizeof(entry));
+        Uint64 bytes = static_cast<Uint64>(entry.width) * entry.height * 4;
+        valid = paths[i] == string(entry.path, strnlen(entry.path, sizeof(entry.path))) &&
+                entry.offset <= size && bytes <= size - entry.offset;
+        if (!valid) break;
+        // SDL never writes through these pixels; the mapping is read-only
+        images[i] = SDL_CreateRGBSurfaceWithFormatFrom(const_cast<unsigned char*>(data + entry.offset), entry.width,
+                                                       entry.height, 32, entry.width * 4, SDL_PIXELFORMAT_RGBA32);
+        valid = images[i] != nullptr;
+    }
+    if (!valid) {
+        cerr << "Ignoring asset bundle " << bundlePath << ": it does not match the image list" << endl;
+        for (auto& image : images) {
+            if (image) SDL_FreeSurface(image);
+            image = nullptr;
         }
-        textures.push_back(newTexture);
+        bundle.close();
     }
+    return valid;
+}
+
+// Decodes the images and stores them as a bundle for mapBundle
+bool UI_ImageLoader::writeBundle(const vector<string>& paths, const string& bundlePath) {
+    vector<SDL_Surface*> images(paths.size(), nullptr);
+    bool decoded = decodeImages(paths, images);
+    FILE* file = decoded ? fopen(bundlePath.c_str(), "wb") : nullptr;
+    bool written = file != nullptr;
+
+    AssetBundleHeader header = {{'M', 'Z', 'B', 'U', 'N', 'D', 'L', 'E'}, ASSET_BUNDLE_VERSION, static_cast<Uint32>(paths.size())};
+    vector<AssetBundleEntry> entries(paths.size());
+    Uint64 offset = sizeof(header) + entries.size() * sizeof(AssetBundleEntry);
+    for (size_t i = 0; written && i < paths.size(); i++) {
+        if (paths[i].size() >= sizeof(entries[i].path)) {
+            cerr << "Path too long for the asset bundle: " << paths[i] << endl;
+            written = false;
+            break;
+        }
+        memset(&entries[i], 0, sizeof(entries[i]));
+        memcpy(entries[i].path, paths[i].c_str(), paths[i].size());
+        entries[i].width = images[i]->w;
+        entries[i].height = images[i]->h;
+        offset = (offset + 63) / 64 * 64;
+        entries[i].offset = offset;
+        offset += static_cast<Uint64>(images[i]->w) * images[i]->h * 4;
+    }
+
+    if (written) {
+        written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  fwrite(entries.data(), sizeof(AssetBundleEntry), entries.size(), file) == entries.size();
+        long position = static_cast<long>(sizeof(header) + entries.size() * sizeof(AssetBundleEntry));
+        const char padding[64] = {};
+        for (size_t i = 0; written && i < paths.size(); i++) {
+            written = fwrite(padding, 1, entries[i].offset - position, file) == entries[i].offset - position;
+            for (int row = 0; written && row < images[i]->h; row++) {
+                const char* pixels = static_cast<const char*>(images[i]->pixels) + row * images[i]->pitch;
+                written = fwrite(pixels, images[i]->w * 4, 1, file) == 1;
+            }
+            position = static_cast<long>(entries[i].offset + static_cast<Uint64>(images[i]->w) * images[i]->h * 4);
+        }
+    }
+    if (file && fclose(file) != 0) written = false;
+
+    for (auto image : images) {
+        if (image) SDL_FreeSurface(image);
+    }
+    if (written) cout << "Wrote " << paths.size() << " images to " << bundlePath << endl;
+    else cerr << "Unable to write asset bundle " << bundlePath << endl;
+    return written;
+}
+
+// GPU upload; everything here must stay on the render thread
+bool UI_ImageLoader::uploadImages(SDL_Renderer* renderer, const vector<SDL_Surface*>& images) {
+    bool uploaded = true;
+    textures.assign(images.size(), nullptr);
+    for (size_t i = 0; i < images.size(); i++) {
+        if (!isBackground(static_cast<int>(i)) || !images[i]) continue;
+        textures[i] = SDL_CreateTextureFromSurface(renderer, images[i]);
+        if (!textures[i]) {
+            cerr << "Unable to create texture from " << imagePaths[i] << "! SDL Error: " << SDL_GetError() << endl;
+            uploaded = false;
+        }
+    }
+    return buildAtlas(renderer, images) && uploaded;
+}
+
+// Packs the prepared sprite slots into one texture in a row-major grid,
+// followed by an all-white slot used by UI_SpriteBatch::addRect
+bool UI_ImageLoader::buildAtlas(SDL_Renderer* renderer, const vector<SDL_Surface*>& images) {
+    const int slotsPerRow = 4;
+    int slotCount = 1; // White block
+    for (size_t i = 0; i < images.size(); i++) {
+        if (!isBackground(static_cast<int>(i))) slotCount++;
+    }
+    int atlasWidth = slotsPerRow * ATLAS_SLOT_SIZE;
+    int atlasHeight = (slotCount + slotsPerRow - 1) / slotsPerRow * ATLAS_SLOT_SIZE;
+
+    SDL_Surface* atlasSurface = SDL_CreateRGBSurfaceWithFormat(0, atlasWidth, atlasHeight, 32, SDL_PIXELFORMAT_RGBA32);
+    if (!atlasSurface) {
+        cerr << "Unable to create sprite atlas! SDL Error: " << SDL_GetError() << endl;
+        return false;
+    }
+    SDL_FillRect(atlasSurface, nullptr, 0);
+
+    atlasUV.assign(images.size(), {0, 0, 0, 0});
+    int nextSlot = 0;
+    // A null slotImage leaves the slot transparent, or fills it white for the white block
+    auto placeSlot = [&](SDL_Surface* slotImage, SDL_FRect& uv, bool white) {
+        int x = (nextSlot % slotsPerRow) * ATLAS_SLOT_SIZE;
+        int y = (nextSlot / slotsPerRow) * ATLAS_SLOT_SIZE;
+        nextSlot++;
+        uv = {static_cast<float>(x + ATLAS_GUTTER) / atlasWidth, static_cast<float>(y + ATLAS_GUTTER) / atlasHeight,
+              static_cast<float>(ATLAS_SPRITE_SIZE) / atlasWidth, static_cast<float>(ATLAS_SPRITE_SIZE) / atlasHeight};
+        Uint8* destination = static_cast<Uint8*>(atlasSurface->pixels) + y * atlasSurface->pitch + x * 4;
+        if (white) {
+            SDL_Rect block = {x, y, ATLAS_SLOT_SIZE, ATLAS_SLOT_SIZE};
+            SDL_FillRect(atlasSurface, &block, 0xFFFFFFFF);
+        }
+        if (!slotImage) return;
+        for (int row = 0; row < ATLAS_SLOT_SIZE; row++) {
+            memcpy(destination + row * atlasSurface->pitch,
+                   static_cast<const Uint8*>(slotImage->pixels) + row * slotImage->pitch, ATLAS_SLOT_SIZE * 4);
+        }
+    };
+
+    for (size_t i = 0; i < images.size(); i++) {
+        if (isBackground(static_cast<int>(i))) continue;
+        bool usable = images[i] && images[i]->w == ATLAS_SLOT_SIZE && images[i]->h == ATLAS_SLOT_SIZE;
+        placeSlot(usable ? images[i] : nullptr, atlasUV[i], false);
+    }
+    placeSlot(nullptr, whiteUV, true);
+
+    atlas = SDL_CreateTextureFromSurface(renderer, atlasSurface);
+    SDL_FreeSurface(atlasSurface);
+    if (!atlas) {
+        cerr << "Unable to create sprite atlas texture! SDL Error: " << SDL_GetError() << endl;
+        return false;
+    }
+    SDL_SetTextureBlendMode(atlas, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureScaleMode(atlas, SDL_ScaleModeLinear);
     return true;
-}  
\ No newline at end of file
+}
+
+void UI_ImageLoader::releaseTextures() {
+    for (auto texture : textures) {
+        if (texture) SDL_DestroyTexture(texture);
+    }
+    textures.clear();
+    if (atlas) SDL_DestroyTexture(atlas);
+    atlas = nullptr;
+}
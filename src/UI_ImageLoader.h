@@ -5,16 +5,56 @@
 #include <SDL2/SDL_image.h>
 #include <string>
 #include <vector>
+#include "UI_MappedFile.h"
+const int ATLAS_SPRITE_SIZE = 128; // Sprites are drawn at CELL_SIZE, so the 1080px sources are shrunk at load time
+const int ATLAS_GUTTER = 2;        // Edge pixels repeated around each sprite so linear filtering never bleeds
+const int ATLAS_SLOT_SIZE = ATLAS_SPRITE_SIZE + 2 * ATLAS_GUTTER;
+const char ASSET_BUNDLE_PATH[] = "ui files/assets.bundle";
 using namespace std;
 
+// Pre-baked images: a header, one entry per image path and then the
+// RGBA32 pixels of every image, each block starting on a 64-byte boundary.
+// Sprites are stored already shrunk into their atlas slot, so loading the
+// bundle is a memory map followed by the GPU upload.
+struct AssetBundleHeader {
+    char magic[8];      // "MZBUNDLE"
+    Uint32 version;
+    Uint32 imageCount;
+};
+
+struct AssetBundleEntry {
+    char path[64];
+    Uint32 width;
+    Uint32 height;
+    Uint64 offset;      // From the start of the file; pitch is width * 4
+};
+
+const Uint32 ASSET_BUNDLE_VERSION = 1;
+
 class UI_ImageLoader {
 public: 
-    vector<SDL_Texture*> textures;
+    UI_ImageLoader();
+    vector<SDL_Texture*> textures;   // Full-screen backgrounds only; sprite slots stay nullptr
     vector<string> imagePaths;
+    SDL_Texture* atlas;              // Every sprite plus a white block for solid rectangles
+    vector<SDL_FRect> atlasUV;       // Normalized atlas rectangle per image, indexed like imagePaths
+    SDL_FRect whiteUV;
     void generatePathsForVector();
     bool loadImages(SDL_Renderer* renderer, const vector<string>& paths);
+    bool writeBundle(const vector<string>& paths, const string& bundlePath);
+    void releaseTextures();
+    static bool isBackground(int index);
+
+private:
+    bool mapBundle(const vector<string>& paths, const string& bundlePath, vector<SDL_Surface*>& images);
+    bool decodeImages(const vector<string>& paths, vector<SDL_Surface*>& images);
+    SDL_Surface* prepareImage(const string& path, int index);
+    bool uploadImages(SDL_Renderer* renderer, const vector<SDL_Surface*>& images);
+    bool buildAtlas(SDL_Renderer* renderer, const vector<SDL_Surface*>& images);
+
+    UI_MappedFile bundle;
 };
 
 extern UI_ImageLoader imageLoader;
 
-#endif
\ No newline at end of file
+#endif
@@ -9,10 +9,8 @@ UI_Board uiBoard;
 UI_MAIN::UI_MAIN() : window(nullptr), renderer(nullptr) {}
 
 UI_MAIN::~UI_MAIN() {
-    for (auto texture : imageLoader.textures) {
-        SDL_DestroyTexture(texture);
-    }
-    imageLoader.textures.clear();
+    uiBoard.releaseTextures();
+    imageLoader.releaseTextures();
 
     if (renderer) SDL_DestroyRenderer(renderer);
     if (window) SDL_DestroyWindow(window);
@@ -21,7 +19,7 @@ UI_MAIN::~UI_MAIN() {
     SDL_Quit();
 }
 
-bool UI_MAIN::initialize() {
+bool UI_MAIN::initialize(bool vsync) {
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         cerr << "No se pudo inicializar SDL: " << SDL_GetError() << ::endl;
         return false;
@@ -36,7 +34,8 @@ bool UI_MAIN::initialize() {
         return false;
     }
 
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    Uint32 rendererFlags = SDL_RENDERER_ACCELERATED | (vsync ? SDL_RENDERER_PRESENTVSYNC : 0);
+    renderer = SDL_CreateRenderer(window, -1, rendererFlags);
     if (!renderer) {
         cerr << "El renderizador no pudo ser creado: " << SDL_GetError() << endl;
         SDL_DestroyWindow(window);
@@ -49,6 +48,7 @@ bool UI_MAIN::initialize() {
         cerr << "SDL_image no pudo ser inicializado. IMG_Error: " << IMG_GetError() << endl;
         return false;
     }
+    IMG_Init(IMG_INIT_JPG); // winscreen.png is a JPEG; loaded up front so decoder threads never race to load it
 
     if (TTF_Init() == -1) {
         std::cerr << "SDL_ttf no pudo ser inicializado. TTF_Error: " << TTF_GetError() << std::endl;
@@ -61,14 +61,18 @@ bool UI_MAIN::initialize() {
     return true;
 }
 
+void UI_MAIN::invalidateBoard() {
+    uiBoard.invalidate();
+}
+
 SDL_Renderer* UI_MAIN::getRenderer() const {
     return renderer;
 }
 
-void UI_MAIN::runMainProgram(SDL_Renderer* renderer, int** playerBoard, int rows, int cols) {
+// Draws a game frame; the main loop presents it after the profiler overlay
+void UI_MAIN::runMainProgram(SDL_Renderer* renderer, nodeMatrix& matrix, const Player& player1, const Player& player2, const UI_Camera& camera) {
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
     SDL_RenderClear(renderer);
 
-    uiBoard.renderBoard(renderer, playerBoard, rows, cols);
-
-    SDL_RenderPresent(renderer);
+    uiBoard.renderBoard(renderer, matrix, player1, player2, camera);
 }
\ No newline at end of file
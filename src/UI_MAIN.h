@@ -6,17 +6,22 @@
 #include <SDL2/SDL_ttf.h>
 #include <string>
 #include <vector>
+#include "UI_Camera.h"
+#include "backend.h"
 const int WINDOW_WIDTH = 1280;
 const int WINDOW_HEIGHT = 720;
+const int DEFAULT_TARGET_FPS = 60;  // Frame cap when vsync is off; 0 renders as fast as events arrive
+const int IDLE_WAIT_MS = 1000;      // Longest the main loop sleeps in SDL_WaitEventTimeout
 using namespace std;
 
 class UI_MAIN {
 public:
     UI_MAIN();
     ~UI_MAIN();
-    bool initialize();
+    bool initialize(bool vsync = true);
     SDL_Renderer* getRenderer() const;
-    void runMainProgram(SDL_Renderer* renderer, int** playerBoard, int rows, int cols);
+    void runMainProgram(SDL_Renderer* renderer, nodeMatrix& matrix, const Player& player1, const Player& player2, const UI_Camera& camera);
+    void invalidateBoard();
 
 private:
     SDL_Window* window;
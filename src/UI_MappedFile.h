@@ -0,0 +1,30 @@
+#ifndef UI_MAPPEDFILE_H
+#define UI_MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+using namespace std;
+
+// Read-only memory mapping of a whole file (mmap, or CreateFileMapping on Windows)
+class UI_MappedFile {
+public:
+    UI_MappedFile();
+    ~UI_MappedFile();
+    bool open(const string& path);
+    void close();
+    const unsigned char* data() const;
+    size_t size() const;
+
+private:
+    UI_MappedFile(const UI_MappedFile&) = delete;
+    UI_MappedFile& operator=(const UI_MappedFile&) = delete;
+
+    const unsigned char* mappedData;
+    size_t mappedSize;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
+
+#endif
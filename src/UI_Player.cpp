@@ -1,57 +1,43 @@
 #include "UI_Cell.h"
 #include "UI_ImageLoader.h"
 #include "UI_Player.h"
+#include "backend.h"
 #include <iostream>
 using namespace std;
 
 UI_Player::UI_Player() :  positionX(0), positionY(0), jumpWallAmount(0) {}
 
-void UI_Player::renderPlayer(SDL_Renderer* renderer, int row, int col, int num) {
+void UI_Player::renderPlayer(UI_SpriteBatch& batch, int row, int col, int num) {
     SDL_Rect player = {col * CELL_SIZE, row * CELL_SIZE, CELL_SIZE, CELL_SIZE};
-    if (!imageLoader.textures.empty()) {
-        SDL_RenderCopy(renderer, imageLoader.textures[num], nullptr, &player);
+    if (imageLoader.atlas) {
+        batch.addSprite(player, num);
     } else {
-    SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
-    SDL_RenderFillRect(renderer, &player);
+    batch.addRect(player, {255, 0, 0, 255});
     }
 }
 
-char UI_Player::processInputP1(char& direction) {
-    SDL_Event event;
-    while (SDL_PollEvent(&event)) {
-        if (event.type == SDL_QUIT) {
-            return false;
-        }
-        if (event.type == SDL_KEYDOWN) {
-            switch (event.key.keysym.sym) {
-                case SDLK_w: direction = 'w'; break;
-                case SDLK_s: direction = 's'; break;
-                case SDLK_a: direction = 'a'; break;
-                case SDLK_d: direction = 'd'; break;
-                default: direction = 'x'; break;
-            }
+// Player 1 plays with WASD and E, player 2 with the arrow keys and right
+// Ctrl. Returns the backend action ('W', 'A', 'S', 'D', or USE_POWER for the
+// held power) or 'x' when the key is not one of the current player's keys.
+char UI_Player::directionForKey(SDL_Keycode key, int playerTurn) const {
+    if (playerTurn == 1) {
+        switch (key) {
+            case SDLK_w: return 'W';
+            case SDLK_s: return 'S';
+            case SDLK_a: return 'A';
+            case SDLK_d: return 'D';
+            case SDLK_e: return USE_POWER;
+            default: return 'x';
         }
     }
-    return direction;
-}
-
-char UI_Player::processInputP2(char& direction) {
-    SDL_Event event;
-    while (SDL_PollEvent(&event)) {
-        if (event.type == SDL_QUIT) {
-            return false;
-        }
-        if (event.type == SDL_KEYDOWN) {
-            switch (event.key.keysym.sym) {
-                case SDLK_UP: direction = 'w'; break;
-                case SDLK_DOWN: direction = 's'; break;
-                case SDLK_LEFT: direction = 'a'; break;
-                case SDLK_RIGHT: direction = 'd'; break;
-                default: direction = 'x'; break;
-            }
-        }
+    switch (key) {
+        case SDLK_UP: return 'W';
+        case SDLK_DOWN: return 'S';
+        case SDLK_LEFT: return 'A';
+        case SDLK_RIGHT: return 'D';
+        case SDLK_RCTRL: return USE_POWER;
+        default: return 'x';
     }
-    return direction;
 }
 
 void UI_Player::setPosition(int rowBackend, int colBackend) {
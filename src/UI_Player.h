@@ -3,14 +3,14 @@
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
+#include "UI_SpriteBatch.h"
 using namespace std;
 
 class UI_Player {
 public:
     UI_Player();
-    void renderPlayer(SDL_Renderer* renderer, int row, int col, int num);
-    char processInputP1(char& direction);
-    char processInputP2(char& direction);
+    void renderPlayer(UI_SpriteBatch& batch, int row, int col, int num);
+    char directionForKey(SDL_Keycode key, int playerTurn) const;
     void setPosition(int rowBackend, int colBackend);
     void setJumpWallAmount(int jwAmountBackend);
     int getJumpWallAmount() const;
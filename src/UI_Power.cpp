@@ -11,13 +11,11 @@ UI_Power::~UI_Power() {
     SDL_Quit();
 }
 
-void UI_Power::renderPower(SDL_Renderer* renderer, int row, int col, int num) {         
+void UI_Power::renderPower(UI_SpriteBatch& batch, int row, int col, int num) {         
     SDL_Rect powerForCell = {col * CELL_SIZE + BORDER_WIDTH, row * CELL_SIZE + BORDER_WIDTH, 
                           CELL_SIZE - 2 * BORDER_WIDTH, CELL_SIZE - 2 * BORDER_WIDTH};
             
-    if (!imageLoader.textures.empty()) {
-        SDL_RenderCopy(renderer, imageLoader.textures[num], nullptr, &powerForCell);
+    if (imageLoader.atlas) {
+        batch.addSprite(powerForCell, num);
     }
-
-    SDL_RenderPresent(renderer);
 }
\ No newline at end of file
@@ -3,13 +3,14 @@
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
+#include "UI_SpriteBatch.h"
 using namespace std;
 
 class UI_Power {
 public:
     UI_Power();
     ~UI_Power();
-    void renderPower(SDL_Renderer* renderer, int row, int col, int num);
+    void renderPower(UI_SpriteBatch& batch, int row, int col, int num);
 
 private:
     SDL_Texture* texture;
@@ -0,0 +1,173 @@
+#include "UI_Profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+using namespace std;
+
+const char* phaseNames[PHASE_COUNT] = {"input", "update", "render", "present"};
+
+// First font found is used; without one the overlay shows only the graph
+const char* fontPaths[] = {
+    "ui files/font.ttf",
+    "C:/Windows/Fonts/consola.ttf",
+    "C:/Windows/Fonts/arial.ttf",
+    "/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf",
+    "/usr/share/fonts/TTF/DejaVuSansMono.ttf",
+    "/System/Library/Fonts/Menlo.ttc",
+};
+
+UI_Profiler::UI_Profiler()
+    : samples(PROFILER_HISTORY), nextSample(0), sampleCount(0), frameNumber(0), current(),
+      frameStart(0), phaseStart(0), ticksPerMs(SDL_GetPerformanceFrequency() / 1000.0),
+      visible(false), font(nullptr), fontSearched(false), textTexture(nullptr),
+      textWidth(0), textHeight(0), lastTextUpdate(0) {}
+
+UI_Profiler::~UI_Profiler() {
+    releaseTextures();
+    if (font && TTF_WasInit()) TTF_CloseFont(font);
+}
+
+// Textures are owned by the renderer, so this must run before it is destroyed
+void UI_Profiler::releaseTextures() {
+    if (textTexture) SDL_DestroyTexture(textTexture);
+    textTexture = nullptr;
+}
+
+void UI_Profiler::startFrame() {
+    current = FrameSample();
+    frameStart = phaseStart = SDL_GetPerformanceCounter();
+}
+
+// Charges the time since the previous mark to this phase
+void UI_Profiler::endPhase(ProfilerPhase phase) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    current.phaseMs[phase] += (now - phaseStart) / ticksPerMs;
+    phaseStart = now;
+}
+
+void UI_Profiler::endFrame() {
+    current.totalMs = (SDL_GetPerformanceCounter() - frameStart) / ticksPerMs;
+    samples[nextSample] = current;
+    nextSample = (nextSample + 1) % PROFILER_HISTORY;
+    sampleCount = min(sampleCount + 1, PROFILER_HISTORY);
+    frameNumber++;
+}
+
+// F1 toggles the overlay, F2 dumps the samples. Returns true if the key was used.
+bool UI_Profiler::handleKey(SDL_Keycode key) {
+    if (key == SDLK_F1) {
+        visible = !visible;
+        return true;
+    }
+    if (key == SDLK_F2) {
+        string path = "profile_" + to_string(SDL_GetTicks()) + ".csv";
+        if (dumpCsv(path)) cout << "Frame profile written to " << path << endl;
+        return true;
+    }
+    return false;
+}
+
+bool UI_Profiler::isVisible() const {
+    return visible;
+}
+
+double UI_Profiler::percentile(double fraction) const {
+    if (sampleCount == 0) return 0;
+    vector<double> totals(sampleCount);
+    for (int i = 0; i < sampleCount; i++) totals[i] = samples[i].totalMs;
+    auto nth = totals.begin() + min(sampleCount - 1, static_cast<int>(fraction * sampleCount));
+    nth_element(totals.begin(), nth, totals.end());
+    return *nth;
+}
+
+bool UI_Profiler::dumpCsv(const string& path) const {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        cerr << "Unable to write " << path << endl;
+        return false;
+    }
+    fprintf(file, "frame,input_ms,update_ms,render_ms,present_ms,total_ms\n");
+    int oldest = (nextSample - sampleCount + PROFILER_HISTORY) % PROFILER_HISTORY;
+    for (int i = 0; i < sampleCount; i++) {
+        const FrameSample& sample = samples[(oldest + i) % PROFILER_HISTORY];
+        fprintf(file, "%lld,%.3f,%.3f,%.3f,%.3f,%.3f\n", frameNumber - sampleCount + i,
+                sample.phaseMs[PHASE_INPUT], sample.phaseMs[PHASE_UPDATE],
+                sample.phaseMs[PHASE_RENDER], sample.phaseMs[PHASE_PRESENT], sample.totalMs);
+    }
+    fclose(file);
+    return true;
+}
+
+bool UI_Profiler::openFont() {
+    if (!fontSearched) {
+        fontSearched = true;
+        for (const char* path : fontPaths) {
+            font = TTF_OpenFont(path, 16);
+            if (font) break;
+        }
+        if (!font) cerr << "Profiler: no font found, showing the graph only" << endl;
+    }
+    return font != nullptr;
+}
+
+// Rebuilds the text texture; rendering text every frame would itself show up as a stall
+void UI_Profiler::refreshText(SDL_Renderer* renderer) {
+    Uint32 now = SDL_GetTicks();
+    if (textTexture && now - lastTextUpdate < PROFILER_TEXT_REFRESH_MS) return;
+    if (!openFont() || sampleCount == 0) return;
+    lastTextUpdate = now;
+
+    const FrameSample& last = samples[(nextSample - 1 + PROFILER_HISTORY) % PROFILER_HISTORY];
+    char line[160];
+    int length = snprintf(line, sizeof(line), "frame %.2f ms  p50 %.2f  p95 %.2f  p99 %.2f |",
+                          last.totalMs, percentile(0.50), percentile(0.95), percentile(0.99));
+    for (int phase = 0; phase < PHASE_COUNT && length < static_cast<int>(sizeof(line)); phase++) {
+        length += snprintf(line + length, sizeof(line) - length, " %s %.2f", phaseNames[phase], last.phaseMs[phase]);
+    }
+
+    SDL_Surface* surface = TTF_RenderText_Blended(font, line, {255, 255, 255, 255});
+    if (!surface) return;
+    releaseTextures();
+    textTexture = SDL_CreateTextureFromSurface(renderer, surface);
+    textWidth = surface->w;
+    textHeight = surface->h;
+    SDL_FreeSurface(surface);
+}
+
+// Draws on top of whatever the frame holds; call between rendering and present
+void UI_Profiler::renderOverlay(SDL_Renderer* renderer) {
+    if (!visible) return;
+    const int graphHeight = 80;
+    const int barWidth = 2;
+    const double graphScaleMs = 33.3; // Full height is two 60 Hz frames
+    int top = textTexture ? textHeight + 4 : 0;
+
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_Rect panel = {0, 0, PROFILER_HISTORY * barWidth + 8, top + graphHeight + 8};
+    if (textTexture) panel.w = max(panel.w, textWidth + 8);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 180);
+    SDL_RenderFillRect(renderer, &panel);
+
+    refreshText(renderer);
+    if (textTexture) {
+        SDL_Rect text = {4, 2, textWidth, textHeight};
+        SDL_RenderCopy(renderer, textTexture, nullptr, &text);
+    }
+
+    // Oldest frame on the left; one fill call for all bars
+    bars.clear();
+    int oldest = (nextSample - sampleCount + PROFILER_HISTORY) % PROFILER_HISTORY;
+    for (int i = 0; i < sampleCount; i++) {
+        double ms = samples[(oldest + i) % PROFILER_HISTORY].totalMs;
+        int height = max(1, min(graphHeight, static_cast<int>(ms / graphScaleMs * graphHeight)));
+        bars.push_back({4 + i * barWidth, top + 4 + graphHeight - height, barWidth, height});
+    }
+    SDL_SetRenderDrawColor(renderer, 80, 220, 80, 255);
+    if (!bars.empty()) SDL_RenderFillRects(renderer, bars.data(), static_cast<int>(bars.size()));
+
+    // 16.7 ms reference line
+    SDL_SetRenderDrawColor(renderer, 220, 80, 80, 255);
+    int budgetY = top + 4 + graphHeight - static_cast<int>(16.7 / graphScaleMs * graphHeight);
+    SDL_RenderDrawLine(renderer, 4, budgetY, 4 + PROFILER_HISTORY * barWidth, budgetY);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+}
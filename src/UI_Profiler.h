@@ -0,0 +1,59 @@
+#ifndef UI_PROFILER_H
+#define UI_PROFILER_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <string>
+#include <vector>
+const int PROFILER_HISTORY = 240;         // Frames kept for the graph, percentiles and CSV
+const int PROFILER_TEXT_REFRESH_MS = 250; // The text is re-rendered at most this often
+using namespace std;
+
+enum ProfilerPhase { PHASE_INPUT, PHASE_UPDATE, PHASE_RENDER, PHASE_PRESENT, PHASE_COUNT };
+
+// Per-phase frame timings for the main loop. The loop marks the end of each
+// phase; the overlay (F1) shows the latest split, a rolling frame-time graph
+// and percentiles, and F2 writes the kept samples to a CSV file.
+class UI_Profiler {
+public:
+    UI_Profiler();
+    ~UI_Profiler();
+    void startFrame();
+    void endPhase(ProfilerPhase phase);
+    void endFrame();
+    bool handleKey(SDL_Keycode key);
+    bool isVisible() const;
+    void renderOverlay(SDL_Renderer* renderer);
+    bool dumpCsv(const string& path) const;
+    void releaseTextures();
+
+private:
+    struct FrameSample {
+        double phaseMs[PHASE_COUNT];
+        double totalMs;
+    };
+
+    bool openFont();
+    double percentile(double fraction) const;
+    void refreshText(SDL_Renderer* renderer);
+
+    vector<FrameSample> samples; // Ring buffer of PROFILER_HISTORY frames
+    int nextSample;
+    int sampleCount;
+    long long frameNumber;
+    FrameSample current;
+    Uint64 frameStart;
+    Uint64 phaseStart;
+    double ticksPerMs;
+
+    bool visible;
+    TTF_Font* font;
+    bool fontSearched;
+    SDL_Texture* textTexture;
+    int textWidth;
+    int textHeight;
+    Uint32 lastTextUpdate;
+    vector<SDL_Rect> bars;
+};
+
+#endif
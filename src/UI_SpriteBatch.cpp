@@ -0,0 +1,70 @@
+#include "UI_ImageLoader.h"
+#include "UI_SpriteBatch.h"
+#include <iostream>
+using namespace std;
+
+UI_SpriteBatch::UI_SpriteBatch() : offsetX(0), offsetY(0), scale(1) {}
+
+void UI_SpriteBatch::clear() {
+    vertices.clear();
+    indices.clear();
+}
+
+bool UI_SpriteBatch::empty() const {
+    return indices.empty();
+}
+
+// screen = board * scale + offset for every quad added from now on
+void UI_SpriteBatch::setTransform(float offsetX, float offsetY, float scale) {
+    this->offsetX = offsetX;
+    this->offsetY = offsetY;
+    this->scale = scale;
+}
+
+SDL_FRect UI_SpriteBatch::toFloat(const SDL_Rect& rect) {
+    return {static_cast<float>(rect.x), static_cast<float>(rect.y), static_cast<float>(rect.w), static_cast<float>(rect.h)};
+}
+
+void UI_SpriteBatch::addQuad(const SDL_FRect& destination, const SDL_FRect& uv, SDL_Color color) {
+    float left = destination.x * scale + offsetX;
+    float top = destination.y * scale + offsetY;
+    float right = left + destination.w * scale;
+    float bottom = top + destination.h * scale;
+    int first = static_cast<int>(vertices.size());
+
+    vertices.push_back({{left, top}, color, {uv.x, uv.y}});
+    vertices.push_back({{right, top}, color, {uv.x + uv.w, uv.y}});
+    vertices.push_back({{right, bottom}, color, {uv.x + uv.w, uv.y + uv.h}});
+    vertices.push_back({{left, bottom}, color, {uv.x, uv.y + uv.h}});
+
+    const int corners[6] = {0, 1, 2, 0, 2, 3};
+    for (int corner : corners) indices.push_back(first + corner);
+}
+
+void UI_SpriteBatch::addSprite(const SDL_Rect& destination, int num) {
+    addSprite(toFloat(destination), num);
+}
+
+void UI_SpriteBatch::addSprite(const SDL_FRect& destination, int num) {
+    addQuad(destination, imageLoader.atlasUV[num], {255, 255, 255, 255});
+}
+
+void UI_SpriteBatch::addRect(const SDL_Rect& destination, SDL_Color color) {
+    addRect(toFloat(destination), color);
+}
+
+void UI_SpriteBatch::addRect(const SDL_FRect& destination, SDL_Color color) {
+    addQuad(destination, imageLoader.whiteUV, color);
+}
+
+// Draws everything queued since clear() and empties the batch
+bool UI_SpriteBatch::flush(SDL_Renderer* renderer) {
+    if (indices.empty()) return true;
+    bool drawn = SDL_RenderGeometry(renderer, imageLoader.atlas, vertices.data(), static_cast<int>(vertices.size()),
+                                    indices.data(), static_cast<int>(indices.size())) == 0;
+    if (!drawn) {
+        cerr << "Unable to draw sprite batch! SDL Error: " << SDL_GetError() << endl;
+    }
+    clear();
+    return drawn;
+}
@@ -0,0 +1,35 @@
+#ifndef UI_SPRITEBATCH_H
+#define UI_SPRITEBATCH_H
+
+#include <SDL2/SDL.h>
+#include <vector>
+using namespace std;
+
+// Collects textured quads from the sprite atlas and submits them with a
+// single SDL_RenderGeometry call. Solid rectangles use the atlas' white
+// texel, so they share the same draw call as the sprites. Positions are
+// board pixels (CELL_SIZE per cell) mapped through the current transform.
+class UI_SpriteBatch {
+public:
+    UI_SpriteBatch();
+    void clear();
+    bool empty() const;
+    void setTransform(float offsetX, float offsetY, float scale);
+    void addSprite(const SDL_Rect& destination, int num);
+    void addSprite(const SDL_FRect& destination, int num);
+    void addRect(const SDL_Rect& destination, SDL_Color color);
+    void addRect(const SDL_FRect& destination, SDL_Color color);
+    bool flush(SDL_Renderer* renderer);
+
+private:
+    void addQuad(const SDL_FRect& destination, const SDL_FRect& uv, SDL_Color color);
+    static SDL_FRect toFloat(const SDL_Rect& rect);
+
+    vector<SDL_Vertex> vertices;
+    vector<int> indices;
+    float offsetX;
+    float offsetY;
+    float scale;
+};
+
+#endif
@@ -14,8 +14,6 @@ void UI_TitleScreen::runTitleScreen(SDL_Renderer* renderer) {
     SDL_Rect playButton = {(1280-buttonWidth)/2, 550, buttonWidth, buttonHeight};
     SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
     SDL_RenderFillRect(renderer, &playButton);
-
-    SDL_RenderPresent(renderer);
 }
 
 bool isPointInRect(int x, int y, SDL_Rect rect) {
@@ -3,11 +3,12 @@
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
+#include "UI_SpriteBatch.h"
 using namespace std;
 
 class UI_Treasure {
 public:
-    void renderTreasure(SDL_Renderer* renderer, int row, int col);
+    void renderTreasure(UI_SpriteBatch& batch, int row, int col);
     void runWinScreen(SDL_Renderer* renderer, int winnerPlayer);
 };
 
@@ -0,0 +1,3875 @@
+#ifndef BACKEND_H
+#define BACKEND_H
+
+#include <iostream>
+#include <queue>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const int rows = 10;
+const int columns = 10;
+const int directionSize = 4;
+const int sublistAmount = 2;
+const int startRow = 0;
+const int startColumn = 0;
+
+const double EXTRA_EDGE_PROB = 0.2;
+const int MAZE_BLOCK_SIZE = 64; // Maze blocks are one 64-bit wall word wide
+const int DEFAULT_PORTAL_PAIRS = 1;
+const int DEFAULT_POWER_PICKUPS = 1;
+const int MAX_POWER_PICKUPS = 64; // GameState keeps the taken pickups in one 64-bit mask
+
+enum class PowerType { NONE, DOUBLE_PLAY, CONTROL_ENEMY, JUMP_WALL };
+enum class Direction { UP, RIGHT, DOWN, LEFT };
+enum class PlayerTurn { PLAYER1, PLAYER2 };
+
+// Turn action that activates the power a player is holding
+const char USE_POWER = 'E';
+
+// Feature flags stored per cell in nodeMatrix
+const uint8_t CELL_PORTAL = 1 << 0;
+const uint8_t CELL_POWER = 1 << 1;
+const uint8_t CELL_TREASURE = 1 << 2;
+
+// Small fast generator (xoshiro256**) shared by everything that builds a match.
+// A match owns one engine seeded from a single 64-bit seed, so a board can be
+// rebuilt bit-for-bit from that seed. The state is expanded with splitmix64.
+class Rng {
+private:
+    uint64_t state[4];
+
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+public:
+    using result_type = uint64_t;
+
+    explicit Rng(uint64_t seed = 0) {
+        reseed(seed);
+    }
+
+    void reseed(uint64_t seed) {
+        for (int i = 0; i < 4; ++i) {
+            state[i] = mix(seed, i);
+        }
+    }
+
+    // The engine mid-stream, for boards stored with the draws they have used up
+    void getState(uint64_t out[4]) const {
+        std::copy_n(state, 4, out);
+    }
+
+    void setState(const uint64_t in[4]) {
+        std::copy_n(in, 4, state);
+    }
+
+    // splitmix64 of seed advanced to the given stream; used to derive independent seeds
+    static uint64_t mix(uint64_t seed, uint64_t stream) {
+        uint64_t z = seed + (stream + 1) * 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // The only place that touches the OS entropy source
+    static uint64_t randomSeed() {
+        std::random_device rd;
+        return (static_cast<uint64_t>(rd()) << 32) ^ rd();
+    }
+
+    static constexpr uint64_t min() { return 0; }
+    static constexpr uint64_t max() { return ~0ULL; }
+
+    uint64_t operator()() {
+        return next();
+    }
+
+    uint64_t next() {
+        uint64_t result = rotl(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+
+    // Uniform in [0, n) by multiply-shift
+    uint32_t nextBelow(uint32_t n) {
+        return static_cast<uint32_t>(((next() >> 32) * n) >> 32);
+    }
+
+    // Uniform in [0, 1)
+    double nextDouble() {
+        return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    bool chance(double probability) {
+        return nextDouble() < probability;
+    }
+};
+
+class nodeCell {
+public:
+    int info;
+    bool visited;
+    nodeCell* next;
+
+    nodeCell(int d, bool t) : info(d), visited(t), next(nullptr) {}
+};
+
+// Two linked cells: a player stepping onto either end comes out at the other
+class Portal : public nodeCell {
+private:
+    std::pair<int, int> portalA, portalB;
+
+public:
+    Portal() : nodeCell(0, false), portalA({-1, -1}), portalB({-1, -1}) {}
+
+    Portal(const std::pair<int, int>& a, const std::pair<int, int>& b) : nodeCell(0, false), portalA(a), portalB(b) {}
+
+    std::pair<int, int> getPortalAPosition() const {
+        return portalA;
+    }
+
+    std::pair<int, int> getPortalBPosition() const {
+        return portalB;
+    }
+};
+
+class Power : public nodeCell {
+private:
+    bool powerPresence;
+    PowerType powerType;
+    std::pair<int, int> position; // Add position attribute
+
+public:
+    Power() : nodeCell(0, false), powerPresence(false), powerType(PowerType::NONE), position({-1, -1}) {}
+
+    Power(const std::pair<int, int>& pos, PowerType type) : nodeCell(0, false) {
+        placePower(pos, type);
+    }
+
+    bool isPowerPresent() const {
+        return powerPresence;
+    }
+
+    PowerType getPowerType() const {
+        return powerType;
+    }
+
+    std::pair<int, int> getPosition() const {
+        return position; 
+    }
+
+    void placePower(const std::pair<int, int>& pos, PowerType type) {
+        position = pos;
+        powerType = type;
+        powerPresence = type != PowerType::NONE;
+    }
+
+    // The pickup leaves the board once a player takes it
+    void consume() {
+        powerPresence = false;
+    }
+};
+
+
+class Treasure : public nodeCell{
+private:
+    std::pair<int, int> position;
+
+public:
+    Treasure() : nodeCell(-1, false), position({ -1, -1 }) {}
+
+    // Picks uniformly among the cells with equal Manhattan distance to both
+    // starts. In any one row those cells form a single column interval, so the
+    // set is counted row by row and the chosen index located in a second pass:
+    // O(rows) time and no rejection loop. Returns false and clears the position
+    // when no such cell exists (the starts differ in parity).
+    bool placeTreasureEquidistant(Rng& rng, int rows, int columns, const std::pair<int, int>& player1Start, const std::pair<int, int>& player2Start) {
+        position = { -1, -1 };
+        uint64_t count = 0;
+        for (int row = 0; row < rows; ++row) {
+            auto span = equidistantColumns(row, columns, player1Start, player2Start);
+            if (span.first <= span.second) count += span.second - span.first + 1;
+        }
+        if (count == 0) return false;
+
+        uint64_t target = rng.next() % count;
+        for (int row = 0; row < rows; ++row) {
+            auto span = equidistantColumns(row, columns, player1Start, player2Start);
+            if (span.first > span.second) continue;
+            uint64_t width = span.second - span.first + 1;
+            if (target < width) {
+                position = { row, span.first + static_cast<int>(target) };
+                return true;
+            }
+            target -= width;
+        }
+        return false;
+    }
+
+    // Same selection over path distances through the maze (-1 = unreachable),
+    // one entry per cell in row-major order
+    bool placeTreasurePathEquidistant(Rng& rng, int columns, const std::vector<int>& player1Distances, const std::vector<int>& player2Distances) {
+        position = { -1, -1 };
+        uint64_t count = 0;
+        for (size_t i = 0; i < player1Distances.size(); ++i) {
+            count += player1Distances[i] >= 0 && player1Distances[i] == player2Distances[i];
+        }
+        if (count == 0) return false;
+
+        uint64_t target = rng.next() % count;
+        for (size_t i = 0; i < player1Distances.size(); ++i) {
+            if (player1Distances[i] >= 0 && player1Distances[i] == player2Distances[i] && target-- == 0) {
+                position = { static_cast<int>(i / columns), static_cast<int>(i % columns) };
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Columns [first, second] of the given row that are Manhattan-equidistant
+    // from a and b; empty when first > second. |c - a.col| - |c - b.col| steps
+    // by 2 between the two start columns and is constant outside them.
+    static std::pair<int, int> equidistantColumns(int row, int columns, const std::pair<int, int>& a, const std::pair<int, int>& b) {
+        int target = std::abs(row - b.first) - std::abs(row - a.first);
+        int ca = a.second, cb = b.second;
+        std::pair<int, int> span = { 0, -1 };
+        if (ca == cb) {
+            if (target == 0) span = { 0, columns - 1 };
+        } else {
+            int spread = std::abs(cb - ca);
+            int sign = ca < cb ? 1 : -1; // Direction in which the difference grows
+            if (target == -sign * spread) {
+                span = { 0, std::min(ca, cb) };
+            } else if (target == sign * spread) {
+                span = { std::max(ca, cb), columns - 1 };
+            } else if (std::abs(target) < spread && (target + ca + cb) % 2 == 0) {
+                int col = (ca + cb + sign * target) / 2;
+                span = { col, col };
+            }
+        }
+        span.first = std::max(span.first, 0);
+        span.second = std::min(span.second, columns - 1);
+        return span;
+    }
+
+    std::pair<int, int> getPosition() const {
+        return position;
+    }
+
+    void setPosition(const std::pair<int, int>& pos) {
+        position = pos;
+    }
+};
+
+class Player {
+private:
+    std::string playerID;
+    std::pair<int, int> currentPosition;
+    bool hasWon;
+    PlayerTurn turn;
+    PowerType heldPower;   // Picked up, waiting for USE_POWER
+    PowerType activePower; // Activated, applies to the player's next move
+
+public:
+    Player(const std::string& id, const std::pair<int, int>& startPos, PlayerTurn playerTurn)
+        : playerID(id), currentPosition(startPos), hasWon(false), turn(playerTurn),
+          heldPower(PowerType::NONE), activePower(PowerType::NONE) {}
+
+    std::string getPlayerID() const {
+        return playerID;
+    }
+
+    std::pair<int, int> getCurrentPosition() const {
+        return currentPosition;
+    }
+
+    bool getHasWon() const {
+        return hasWon;
+    }
+
+    PlayerTurn getTurn() const {
+        return turn;
+    }
+
+    void setPlayerID(const std::string& id) {
+        playerID = id;
+    }
+
+    void setCurrentPosition(const std::pair<int, int>& pos) {
+        currentPosition = pos;
+    }
+
+    void setHasWon(bool won) {
+        hasWon = won;
+    }
+
+    void setTurn(PlayerTurn playerTurn) {
+        turn = playerTurn;
+    }
+
+    PowerType getHeldPower() const {
+        return heldPower;
+    }
+
+    void setHeldPower(PowerType power) {
+        heldPower = power;
+    }
+
+    PowerType getActivePower() const {
+        return activePower;
+    }
+
+    void setActivePower(PowerType power) {
+        activePower = power;
+    }
+
+    void move(char direction) {
+        int currentRow = currentPosition.first;
+        int currentCol = currentPosition.second;
+
+        switch (direction) {
+            case 'W': // Up
+                currentPosition = std::make_pair(currentRow - 1, currentCol);
+                break;
+            case 'S': // Down
+                currentPosition = std::make_pair(currentRow + 1, currentCol);
+                break;
+            case 'A': // Left
+                currentPosition = std::make_pair(currentRow, currentCol - 1);
+                break;
+            case 'D': // Right
+                currentPosition = std::make_pair(currentRow, currentCol + 1);
+                break;
+            default:
+                std::cout << "Invalid move input." << std::endl;
+                break;
+        }
+    }
+};
+
+// Something that happened while moving a player. Plain data, so it can be
+// copied into a ring buffer and written to a binary log as is.
+enum class GameEventType : uint8_t { BOUNDARY_HIT, WALL_HIT, INVALID_MOVE, TREASURE_FOUND, TELEPORT, POWER_FOUND, POWER_ACTIVATED };
+
+struct GameEvent {
+    GameEventType type;
+    PlayerTurn player;
+    PowerType power;   // POWER_FOUND and POWER_ACTIVATED only
+    char direction;    // Move input that caused the event
+    int32_t row;       // Player position after the event
+    int32_t column;
+};
+
+const size_t EVENT_RING_CAPACITY = 256; // Power of two
+
+// Fixed-capacity event queue filled by nodeMatrix and emptied by whoever
+// consumes events (console, log file, UI, simulator). It never allocates; when
+// nobody drains it the oldest events are overwritten and counted as dropped.
+class EventRing {
+private:
+    GameEvent buffer[EVENT_RING_CAPACITY];
+    uint64_t head = 0; // Next event to pop
+    uint64_t tail = 0; // Next free slot
+    uint64_t droppedEvents = 0;
+
+public:
+    void push(const GameEvent& event) {
+        if (tail - head == EVENT_RING_CAPACITY) {
+            ++head;
+            ++droppedEvents;
+        }
+        buffer[tail++ & (EVENT_RING_CAPACITY - 1)] = event;
+    }
+
+    bool pop(GameEvent& event) {
+        if (head == tail) return false;
+        event = buffer[head++ & (EVENT_RING_CAPACITY - 1)];
+        return true;
+    }
+
+    size_t size() const {
+        return static_cast<size_t>(tail - head);
+    }
+
+    uint64_t getDroppedEvents() const {
+        return droppedEvents;
+    }
+
+    void clear() {
+        head = tail;
+    }
+};
+
+class EventSink {
+public:
+    virtual ~EventSink() = default;
+    virtual void onEvent(const GameEvent& event) = 0;
+};
+
+// Prints events the way the console game always reported them
+class ConsoleEventSink : public EventSink {
+private:
+    std::string playerNames[2];
+
+    static const char* directionName(char direction) {
+        switch (direction) {
+            case 'W': return "up";
+            case 'S': return "down";
+            case 'A': return "left";
+            case 'D': return "right";
+            default: return "?";
+        }
+    }
+
+    static const char* powerName(PowerType power) {
+        switch (power) {
+            case PowerType::DOUBLE_PLAY: return "DOUBLE_PLAY";
+            case PowerType::CONTROL_ENEMY: return "CONTROL_ENEMY";
+            case PowerType::JUMP_WALL: return "JUMP_WALL";
+            default: return "NONE";
+        }
+    }
+
+public:
+    ConsoleEventSink(const std::string& player1Name = "Player 1", const std::string& player2Name = "Player 2")
+        : playerNames{player1Name, player2Name} {}
+
+    void onEvent(const GameEvent& event) override {
+        const std::string& name = playerNames[event.player == PlayerTurn::PLAYER1 ? 0 : 1];
+        switch (event.type) {
+            case GameEventType::BOUNDARY_HIT:
+                std::cout << "Cannot move " << directionName(event.direction) << ". Boundary reached.\n";
+                break;
+            case GameEventType::WALL_HIT:
+                std::cout << "Cannot move " << directionName(event.direction) << ". Wall in the way.\n";
+                break;
+            case GameEventType::INVALID_MOVE:
+                std::cout << "Invalid move input.\n";
+                break;
+            case GameEventType::TREASURE_FOUND:
+                std::cout << name << " has found the treasure and won!\n";
+                break;
+            case GameEventType::TELEPORT:
+                std::cout << name << " teleported to (" << event.row << ", " << event.column << ")!\n";
+                break;
+            case GameEventType::POWER_FOUND:
+                std::cout << name << " found " << powerName(event.power) << "!\n";
+                break;
+            case GameEventType::POWER_ACTIVATED:
+                std::cout << name << " activated " << powerName(event.power) << "!\n";
+                break;
+        }
+    }
+};
+
+// Appends raw GameEvent records (native layout, sizeof(GameEvent) bytes each)
+class BinaryLogEventSink : public EventSink {
+private:
+    std::FILE* file;
+
+public:
+    explicit BinaryLogEventSink(std::FILE* file) : file(file) {}
+
+    void onEvent(const GameEvent& event) override {
+        std::fwrite(&event, sizeof(event), 1, file);
+    }
+};
+
+// Forwards to any callable, e.g. a lambda in the UI or the simulator
+template <typename Callback>
+class CallbackEventSink : public EventSink {
+private:
+    Callback callback;
+
+public:
+    explicit CallbackEventSink(Callback callback) : callback(callback) {}
+
+    void onEvent(const GameEvent& event) override {
+        callback(event);
+    }
+};
+
+// Set on threads that already belong to a pool (parallelFor workers, the
+// simulator's game threads) so nested parallelFor calls run inline
+inline thread_local bool insideWorkerThread = false;
+
+// Runs task(0 .. count - 1) spread over the hardware threads
+template <typename Task>
+void parallelFor(int count, Task task) {
+    int workers = std::min(static_cast<int>(std::max(1u, std::thread::hardware_concurrency())), count);
+    if (workers <= 1 || insideWorkerThread) {
+        for (int i = 0; i < count; ++i) task(i);
+        return;
+    }
+    std::atomic<int> next(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < workers; ++t) {
+        threads.emplace_back([&]() {
+            insideWorkerThread = true;
+            for (int i = next++; i < count; i = next++) task(i);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+}
+
+// Runs task(i, worker) for every i in [0, count) on threads threads, where
+// worker is the calling thread's index, for per-thread state. Each worker
+// starts with an even slice of the indices and runs it from the front; one
+// that runs dry steals the back half of another's slice, starting at a victim
+// picked by its own Rng. Uneven tasks balance out, and the workers only
+// share a lock when one of them steals.
+template <typename Task>
+void workStealingFor(int64_t count, int threads, uint64_t seed, Task task) {
+    threads = static_cast<int>(std::clamp<int64_t>(threads, 1, std::max<int64_t>(count, 1)));
+    struct alignas(64) Slice {
+        std::mutex lock;
+        int64_t begin = 0;
+        int64_t end = 0;
+    };
+    std::vector<Slice> slices(threads);
+    for (int t = 0; t < threads; ++t) {
+        slices[t].begin = count * t / threads;
+        slices[t].end = count * (t + 1) / threads;
+    }
+    auto work = [&](int self) {
+        Rng rng(Rng::mix(seed, static_cast<uint64_t>(self)));
+        Slice& own = slices[self];
+        while (true) {
+            int64_t next = -1;
+            {
+                std::lock_guard<std::mutex> guard(own.lock);
+                if (own.begin < own.end) next = own.begin++;
+            }
+            if (next >= 0) {
+                task(next, self);
+                continue;
+            }
+            // Nothing spawns new tasks, so once every slice is empty the work is done
+            bool stole = false;
+            int first = static_cast<int>(rng.nextBelow(threads));
+            for (int k = 0; k < threads && !stole; ++k) {
+                Slice& victim = slices[(first + k) % threads];
+                if (&victim == &own) continue;
+                int64_t begin, end;
+                {
+                    std::lock_guard<std::mutex> guard(victim.lock);
+                    int64_t left = victim.end - victim.begin;
+                    if (left <= 0) continue;
+                    end = victim.end;
+                    victim.end -= (left + 1) / 2;
+                    begin = victim.end;
+                }
+                std::lock_guard<std::mutex> guard(own.lock);
+                own.begin = begin;
+                own.end = end;
+                stole = true;
+            }
+            if (!stole) return;
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) {
+        pool.emplace_back([&work, t]() {
+            insideWorkerThread = true;
+            work(t);
+        });
+    }
+    bool wasInside = insideWorkerThread;
+    insideWorkerThread = true;
+    work(0);
+    insideWorkerThread = wasInside;
+    for (auto& thread : pool) thread.join();
+}
+
+// Cell to value, as (cell, value) pairs sorted by cell. A board holds few
+// portals and pickups, so a binary search is as quick as hashing, and
+// rebuilding keeps the capacity: a reused board fills it without allocating.
+// Cells are set in any order, then sealed before the first lookup.
+template <typename Value>
+class CellMap {
+private:
+    std::vector<std::pair<int64_t, Value>> entries;
+
+public:
+    using const_iterator = typename std::vector<std::pair<int64_t, Value>>::const_iterator;
+
+    void clear() {
+        entries.clear();
+    }
+
+    void set(int64_t cell, Value value) {
+        entries.emplace_back(cell, value);
+    }
+
+    // Sorts by cell; of several values set for one cell the last is kept
+    void seal() {
+        auto byCell = [](const auto& a, const auto& b) { return a.first < b.first; };
+        if (entries.size() > 64) {
+            std::stable_sort(entries.begin(), entries.end(), byCell);
+        } else {
+            // Insertion sort: as stable, without stable_sort's buffer
+            for (size_t i = 1; i < entries.size(); ++i) {
+                for (size_t j = i; j > 0 && byCell(entries[j], entries[j - 1]); --j) std::swap(entries[j], entries[j - 1]);
+            }
+        }
+        size_t kept = 0;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (i + 1 < entries.size() && entries[i + 1].first == entries[i].first) continue;
+            entries[kept++] = entries[i];
+        }
+        entries.resize(kept);
+    }
+
+    const_iterator find(int64_t cell) const {
+        auto it = std::lower_bound(entries.begin(), entries.end(), cell, [](const auto& entry, int64_t key) { return entry.first < key; });
+        return it != entries.end() && it->first == cell ? it : entries.end();
+    }
+
+    size_t count(int64_t cell) const {
+        return find(cell) != entries.end();
+    }
+
+    const_iterator begin() const {
+        return entries.begin();
+    }
+
+    const_iterator end() const {
+        return entries.end();
+    }
+
+    size_t size() const {
+        return entries.size();
+    }
+
+    bool empty() const {
+        return entries.empty();
+    }
+
+    void swap(CellMap& other) {
+        entries.swap(other.entries);
+    }
+};
+
+// What is on each cell of a board. flags answers with a single byte read and
+// the maps are only consulted for cells whose bit is set, so a lookup costs
+// the same however many portals and pickups the board has. nodeMatrix
+// rebuilds it whenever a feature is added or moved.
+struct FeatureIndex {
+    std::vector<uint8_t> flags;           // CELL_* per cell, row-major; CELL_POWER only while not taken
+    std::vector<uint64_t> portalBits;     // Portal cells in the word layout of the wall planes
+    std::vector<uint64_t> pickupBits;     // Cells a pickup started on, taken or not; bit i is cell i
+    CellMap<int64_t> portalPartners;
+    CellMap<uint32_t> pickupSlots; // Cell to index into pickupTypes
+    std::vector<PowerType> pickupTypes;
+};
+
+// Read-only view of a maze's graph: packed wall planes plus the feature
+// index for portals and pickups. Cells are row-major indices.
+struct MazeView {
+    int rows;
+    int columns;
+    int wordsPerRow;
+    const uint64_t* eastWalls;
+    const uint64_t* southWalls;
+    const FeatureIndex* features; // Null for a bare maze
+
+    bool hasPortals() const {
+        return features && !features->portalPartners.empty();
+    }
+
+    // Portal bits of one wall-plane word
+    uint64_t portalWord(size_t word) const {
+        return features ? features->portalBits[word] : 0;
+    }
+
+    int64_t portalPartner(int64_t cell) const {
+        if (!features || !(features->flags[cell] & CELL_PORTAL)) return -1;
+        return features->portalPartners.find(cell)->second;
+    }
+
+    // Index of the pickup that started on cell, or -1
+    int pickupSlot(int64_t cell) const {
+        if (!features || !((features->pickupBits[cell >> 6] >> (cell & 63)) & 1)) return -1;
+        return static_cast<int>(features->pickupSlots.find(cell)->second);
+    }
+
+    // True when no wall separates the cell from its neighbour in that direction
+    bool canMove(int row, int column, Direction direction) const {
+        switch (direction) {
+            case Direction::UP:
+                return row > 0 && !((southWalls[static_cast<size_t>(row - 1) * wordsPerRow + (column >> 6)] >> (column & 63)) & 1);
+            case Direction::DOWN:
+                return !((southWalls[static_cast<size_t>(row) * wordsPerRow + (column >> 6)] >> (column & 63)) & 1);
+            case Direction::LEFT:
+                return column > 0 && !((eastWalls[static_cast<size_t>(row) * wordsPerRow + ((column - 1) >> 6)] >> ((column - 1) & 63)) & 1);
+            case Direction::RIGHT:
+                return !((eastWalls[static_cast<size_t>(row) * wordsPerRow + (column >> 6)] >> (column & 63)) & 1);
+        }
+        return false;
+    }
+};
+
+// Breadth-first distance map through the maze from one or more sources.
+// Portals are zero-cost edges. The frontier is kept as 64-cell words of the
+// wall planes: each word spreads east/west with shifts and north/south with
+// one mask, so open areas advance 64 cells per operation and sparse maze
+// corridors touch only the words they pass through. All buffers are reused
+// between computations.
+class DistanceField {
+private:
+    struct FrontierWord {
+        uint32_t word;
+        uint32_t row;
+        uint64_t cells;
+    };
+
+    std::vector<int> distances;
+    std::vector<uint64_t> reached;
+    std::vector<FrontierWord> current;
+    std::vector<FrontierWord> next;
+    const uint64_t* portalBits = nullptr; // Null when the maze has no portals
+    int columns = 0;
+
+    // Claims the unreached cells of one word for the given level and queues
+    // them for the next expansion; portal exits are claimed at the same level
+    void claim(const MazeView& maze, size_t word, size_t row, uint64_t cells, int level) {
+        cells &= ~reached[word];
+        if (!cells) return;
+        reached[word] |= cells;
+        next.push_back({static_cast<uint32_t>(word), static_cast<uint32_t>(row), cells});
+        int64_t base = static_cast<int64_t>(row) * maze.columns
+                     + static_cast<int64_t>(word - row * maze.wordsPerRow) * 64;
+        for (uint64_t bits = cells; bits; bits &= bits - 1) {
+            distances[base + __builtin_ctzll(bits)] = level;
+        }
+        if (portalBits && (cells & portalBits[word])) claimPortalExits(maze, base, cells & portalBits[word], level);
+    }
+
+    // Kept out of line so the common claim stays small
+    __attribute__((noinline)) void claimPortalExits(const MazeView& maze, int64_t base, uint64_t portalCells, int level) {
+        for (uint64_t bits = portalCells; bits; bits &= bits - 1) {
+            int64_t partner = maze.portalPartner(base + __builtin_ctzll(bits));
+            size_t partnerRow = partner / maze.columns;
+            int partnerColumn = static_cast<int>(partner % maze.columns);
+            claim(maze, partnerRow * maze.wordsPerRow + (partnerColumn >> 6), partnerRow,
+                  1ULL << (partnerColumn & 63), level);
+        }
+    }
+
+    void spread(const MazeView& maze, const FrontierWord& entry, int level) {
+        size_t word = entry.word;
+        size_t row = entry.row;
+        uint64_t cells = entry.cells;
+        uint64_t east = maze.eastWalls[word];
+
+        // Edge and padding bits are walls, so nothing is carried past the last column
+        uint64_t goEast = cells & ~east;
+        claim(maze, word, row, (goEast << 1) | ((cells >> 1) & ~east), level);
+        if (goEast >> 63) claim(maze, word + 1, row, 1, level);
+        if ((cells & 1) && word > row * maze.wordsPerRow && !(maze.eastWalls[word - 1] >> 63)) {
+            claim(maze, word - 1, row, 1ULL << 63, level);
+        }
+
+        if (row + 1 < static_cast<size_t>(maze.rows)) {
+            claim(maze, word + maze.wordsPerRow, row + 1, cells & ~maze.southWalls[word], level);
+        }
+        if (row > 0) {
+            claim(maze, word - maze.wordsPerRow, row - 1, cells & ~maze.southWalls[word - maze.wordsPerRow], level);
+        }
+    }
+
+public:
+    void compute(const MazeView& maze, const std::vector<int64_t>& sources) {
+        compute(maze, sources.data(), sources.size());
+    }
+
+    void compute(const MazeView& maze, const int64_t* sources, size_t sourceCount) {
+        columns = maze.columns;
+        portalBits = maze.hasPortals() ? maze.features->portalBits.data() : nullptr;
+        distances.assign(static_cast<size_t>(maze.rows) * maze.columns, -1);
+        reached.assign(static_cast<size_t>(maze.rows) * maze.wordsPerRow, 0);
+        next.clear();
+        for (size_t s = 0; s < sourceCount; ++s) {
+            int64_t source = sources[s];
+            if (source < 0) continue;
+            size_t row = source / maze.columns;
+            int column = static_cast<int>(source % maze.columns);
+            claim(maze, row * maze.wordsPerRow + (column >> 6), row, 1ULL << (column & 63), 0);
+        }
+
+        for (int level = 1; !next.empty(); ++level) {
+            std::swap(current, next);
+            next.clear();
+            for (const FrontierWord& entry : current) spread(maze, entry, level);
+        }
+    }
+
+    // Takes a map computed earlier for this maze (a maze library), one entry
+    // per cell in row-major order
+    void assign(const MazeView& maze, const int32_t* values) {
+        static_assert(sizeof(int) == sizeof(int32_t), "distance maps are stored as int32");
+        columns = maze.columns;
+        distances.assign(values, values + static_cast<size_t>(maze.rows) * maze.columns);
+    }
+
+    // -1 when unreachable or not computed
+    int getDistance(int row, int column) const {
+        size_t cell = static_cast<size_t>(row) * columns + column;
+        return cell < distances.size() ? distances[cell] : -1;
+    }
+
+    const std::vector<int>& getDistances() const {
+        return distances;
+    }
+};
+
+// Point-to-point shortest paths for AI players and hints. A* with a
+// Manhattan heuristic that also accounts for the zero-cost portals. With one
+// pair it is the minimum of going straight or through either end. With more,
+// a path may chain portals, so the walk after a portal is only bounded by the
+// shortest walk from any exit: up to PATH_HEURISTIC_PORTAL_ENDS ends it is
+// the minimum of going straight or to the nearest entrance plus that bound,
+// beyond that of going straight or the bound alone. All of these stay
+// consistent. With wallJumps > 0 the search runs over (cell, jumps used)
+// layers, and a jump crosses one inner wall into the neighbouring cell for
+// one move. The jump-point variant skips straight runs in open areas: it
+// follows the 4-connected canonical order (vertical first), treats portal
+// cells as jump points, and falls back to A* when wall jumps are allowed. The
+// inner horizontal scans test 64 columns per step on the wall bit planes.
+// All buffers are kept between queries and only grow with the maze, so a
+// query does not allocate once they are warm.
+class PathFinder {
+public:
+    enum class Method { ASTAR, JUMP_POINT };
+
+private:
+    struct OpenEntry {
+        uint32_t f;
+        uint32_t g;
+        uint32_t node;
+    };
+
+    static constexpr uint8_t ARRIVED_ANY = directionSize;         // Search start: expand every direction
+    static constexpr uint8_t ARRIVED_PORTAL = directionSize + 1;  // Portal exit: expand every direction
+    static constexpr uint32_t NO_PARENT = UINT32_MAX;
+    static constexpr uint32_t NO_ENTRY = UINT32_MAX;
+
+    std::vector<uint32_t> gScore;
+    std::vector<uint32_t> parent;
+    std::vector<uint32_t> seenStamp;
+    std::vector<uint32_t> closedStamp;
+    std::vector<uint8_t> arrival;
+    // Open list as one bucket per f value, each a stack linked through
+    // entries. The heuristic is consistent, so f never drops below the bucket
+    // being expanded, and the stack expands the newest (deepest) node on ties.
+    struct BucketEntry {
+        uint32_t node;
+        uint32_t next;
+    };
+    std::vector<BucketEntry> entries;
+    std::vector<uint32_t> bucketHead;
+    uint32_t currentF = 0;
+    uint32_t highestF = 0;
+    uint32_t stamp = 0;
+    size_t expanded = 0;
+
+    const MazeView* maze = nullptr;
+    int64_t cells = 0;
+    int64_t target = -1;
+    int targetRow = 0;
+    int targetColumn = 0;
+    static constexpr int PATH_HEURISTIC_PORTAL_ENDS = 8;
+
+    bool portals = false;
+    int portalEnds = 0;         // Ends in the per-end heuristic; 0 uses exitToTarget alone
+    int portalRow[PATH_HEURISTIC_PORTAL_ENDS] = {};
+    int portalColumn[PATH_HEURISTIC_PORTAL_ENDS] = {};
+    int portalToTarget[PATH_HEURISTIC_PORTAL_ENDS] = {}; // From the other end of the portal to the target
+    int exitToTarget = 0;       // Shortest of those over every portal
+
+    static int rowStep(int d) { return d == static_cast<int>(Direction::DOWN) ? 1 : d == static_cast<int>(Direction::UP) ? -1 : 0; }
+    static int columnStep(int d) { return d == static_cast<int>(Direction::RIGHT) ? 1 : d == static_cast<int>(Direction::LEFT) ? -1 : 0; }
+
+    static int manhattan(int64_t a, int64_t b, int columns) {
+        return static_cast<int>(std::abs(a / columns - b / columns) + std::abs(a % columns - b % columns));
+    }
+
+    int heuristic(int64_t cell) const {
+        int row = static_cast<int>(cell / maze->columns);
+        int column = static_cast<int>(cell - static_cast<int64_t>(row) * maze->columns);
+        int best = std::abs(row - targetRow) + std::abs(column - targetColumn);
+        if (portals) {
+            best = std::min(best, exitToTarget);
+            for (int end = 0; end < portalEnds; ++end) {
+                best = std::min(best, std::abs(row - portalRow[end]) + std::abs(column - portalColumn[end]) + portalToTarget[end]);
+            }
+        }
+        return best;
+    }
+
+    // Starts a new query; buffers grow only when the maze got bigger
+    void prepare(size_t nodes) {
+        if (gScore.size() < nodes) {
+            // f is at most a path length plus a heuristic; re-opened nodes add entries
+            bucketHead.resize(nodes + maze->rows + maze->columns, NO_ENTRY);
+            entries.reserve(2 * nodes);
+            gScore.resize(nodes);
+            parent.resize(nodes);
+            seenStamp.resize(nodes, 0);
+            closedStamp.resize(nodes, 0);
+            arrival.resize(nodes);
+        }
+        if (++stamp == 0) {
+            std::fill(seenStamp.begin(), seenStamp.end(), 0);
+            std::fill(closedStamp.begin(), closedStamp.end(), 0);
+            stamp = 1;
+        }
+        for (uint32_t f = currentF; f <= highestF && f < bucketHead.size(); ++f) bucketHead[f] = NO_ENTRY;
+        entries.clear();
+        currentF = UINT32_MAX;
+        highestF = 0;
+        expanded = 0;
+    }
+
+    void relax(uint32_t node, int64_t cell, uint32_t g, uint32_t from, uint8_t arrivedBy) {
+        if (seenStamp[node] == stamp && gScore[node] <= g) return;
+        seenStamp[node] = stamp;
+        gScore[node] = g;
+        parent[node] = from;
+        arrival[node] = arrivedBy;
+        uint32_t f = g + static_cast<uint32_t>(heuristic(cell));
+        if (f >= bucketHead.size()) bucketHead.resize(std::max<size_t>(f + 1, bucketHead.size() * 2), NO_ENTRY);
+        entries.push_back({node, bucketHead[f]});
+        bucketHead[f] = static_cast<uint32_t>(entries.size() - 1);
+        currentF = std::min(currentF, f);
+        highestF = std::max(highestF, f);
+    }
+
+    // Pops the next node that is not closed yet, or returns false when none is left
+    bool popOpen(OpenEntry& entry) {
+        for (; currentF <= highestF; ++currentF) {
+            while (bucketHead[currentF] != NO_ENTRY) {
+                uint32_t node = entries[bucketHead[currentF]].node;
+                bucketHead[currentF] = entries[bucketHead[currentF]].next;
+                if (closedStamp[node] == stamp) continue;
+                closedStamp[node] = stamp;
+                ++expanded;
+                entry = {currentF, gScore[node], node};
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool isPortal(int64_t cell) const {
+        return portals && (maze->features->flags[cell] & CELL_PORTAL);
+    }
+
+    // Arriving at (row, column) by direction: the side neighbour is forced
+    // when the canonical route around it (side first, then direction) is blocked
+    bool forcedSide(int row, int column, int direction, int side) const {
+        if (!maze->canMove(row, column, static_cast<Direction>(side))) return false;
+        int previousRow = row - rowStep(direction);
+        int previousColumn = column - columnStep(direction);
+        return !(maze->canMove(previousRow, previousColumn, static_cast<Direction>(side)) &&
+                 maze->canMove(previousRow + rowStep(side), previousColumn + columnStep(side), static_cast<Direction>(direction)));
+    }
+
+    uint64_t eastWord(int row, int word) const {
+        return maze->eastWalls[static_cast<size_t>(row) * maze->wordsPerRow + word];
+    }
+
+    uint64_t openDownWord(int row, int word) const {
+        return ~maze->southWalls[static_cast<size_t>(row) * maze->wordsPerRow + word];
+    }
+
+    // Columns of one 64-column word where a horizontal run has to stop: the
+    // target, a portal, or a forced neighbour above or below. Bit x of the
+    // neighbour words is column x - 1 (right) or x + 1 (left) of this word.
+    uint64_t stopColumns(int row, int word, bool right) const {
+        uint64_t stops = 0;
+        auto columnBit = [&](int64_t cell) {
+            if (cell >= 0 && cell / maze->columns == row && (cell % maze->columns) >> 6 == word) {
+                stops |= 1ULL << (cell % maze->columns & 63);
+            }
+        };
+        columnBit(target);
+        if (portals) stops |= maze->portalWord(static_cast<size_t>(row) * maze->wordsPerRow + word);
+        int lastWord = maze->wordsPerRow - 1;
+        // side row is the row above (open = no south wall there) or the row below
+        for (int sideRow : {row - 1, row + 1}) {
+            if (sideRow < 0 || sideRow >= maze->rows) continue;
+            int wallRow = sideRow < row ? sideRow : row;
+            uint64_t open = openDownWord(wallRow, word);
+            uint64_t openBeside, crossBeside;
+            if (right) {
+                openBeside = (open << 1) | (word > 0 ? openDownWord(wallRow, word - 1) >> 63 : 0);
+                crossBeside = ~((eastWord(sideRow, word) << 1) | (word > 0 ? eastWord(sideRow, word - 1) >> 63 : 1));
+            } else {
+                openBeside = (open >> 1) | (word < lastWord ? openDownWord(wallRow, word + 1) << 63 : 0);
+                crossBeside = ~eastWord(sideRow, word);
+            }
+            stops |= open & ~(openBeside & crossBeside);
+        }
+        return stops;
+    }
+
+    // Runs along the row from column until a wall; returns the first stop
+    // column, checking a whole word of columns per step
+    int64_t jumpHorizontal(int row, int column, int direction) const {
+        bool right = direction == static_cast<int>(Direction::RIGHT);
+        int first = column >> 6;
+        int64_t rowStart = static_cast<int64_t>(row) * maze->columns;
+        if (right) {
+            for (int word = first; word < maze->wordsPerRow; ++word) {
+                uint64_t ahead = word == first ? ~0ULL << (column & 63) : ~0ULL;     // Columns >= column
+                uint64_t walls = eastWord(row, word) & ahead;
+                uint64_t reachable = ahead & ~(word == first ? 1ULL << (column & 63) : 0);
+                if (walls) reachable &= (walls & (0 - walls)) * 2 - 1;              // Up to the first wall
+                uint64_t stops = stopColumns(row, word, true) & reachable;
+                if (stops) return rowStart + word * 64 + __builtin_ctzll(stops);
+                if (walls) return -1;
+            }
+        } else {
+            for (int word = first; word >= 0; --word) {
+                uint64_t behind = word == first ? (1ULL << (column & 63)) - 1 : ~0ULL; // Columns < column
+                uint64_t walls = eastWord(row, word) & behind;
+                uint64_t reachable = behind;
+                if (walls) reachable &= ~((2ULL << (63 - __builtin_clzll(walls))) - 1); // Past the last wall
+                uint64_t stops = stopColumns(row, word, false) & reachable;
+                if (stops) return rowStart + word * 64 + (63 - __builtin_clzll(stops));
+                if (walls) return -1;
+            }
+        }
+        return -1;
+    }
+
+    // A vertical run stops where a horizontal scan finds something to turn towards
+    int64_t jumpVertical(int row, int column, int direction) const {
+        Direction move = static_cast<Direction>(direction);
+        while (maze->canMove(row, column, move)) {
+            row += rowStep(direction);
+            int64_t cell = static_cast<int64_t>(row) * maze->columns + column;
+            if (cell == target || isPortal(cell)) return cell;
+            if (jumpHorizontal(row, column, static_cast<int>(Direction::LEFT)) >= 0 ||
+                jumpHorizontal(row, column, static_cast<int>(Direction::RIGHT)) >= 0) {
+                return cell;
+            }
+        }
+        return -1;
+    }
+
+    int searchAStar(int64_t source, int wallJumps) {
+        prepare(static_cast<size_t>(cells) * (wallJumps + 1));
+        relax(static_cast<uint32_t>(source), source, 0, NO_PARENT, ARRIVED_ANY);
+        OpenEntry entry;
+        while (popOpen(entry)) {
+            int64_t cell = entry.node % cells;
+            uint32_t layer = static_cast<uint32_t>(entry.node / cells);
+            if (cell == target) return static_cast<int>(entry.g);
+            int row = static_cast<int>(cell / maze->columns);
+            int column = static_cast<int>(cell % maze->columns);
+            for (int d = 0; d < directionSize; ++d) {
+                int nextRow = row + rowStep(d);
+                int nextColumn = column + columnStep(d);
+                if (nextRow < 0 || nextRow >= maze->rows || nextColumn < 0 || nextColumn >= maze->columns) continue;
+                int64_t next = static_cast<int64_t>(nextRow) * maze->columns + nextColumn;
+                uint32_t nextLayer = layer;
+                if (!maze->canMove(row, column, static_cast<Direction>(d))) {
+                    if (static_cast<int>(layer) >= wallJumps) continue;
+                    nextLayer = layer + 1;
+                }
+                relax(static_cast<uint32_t>(nextLayer * cells + next), next, entry.g + 1, entry.node, static_cast<uint8_t>(d));
+            }
+            int64_t partner = portals ? maze->portalPartner(cell) : -1;
+            if (partner >= 0) {
+                relax(static_cast<uint32_t>(layer * cells + partner), partner, entry.g, entry.node, ARRIVED_PORTAL);
+            }
+        }
+        return -1;
+    }
+
+    int searchJumpPoint(int64_t source) {
+        prepare(static_cast<size_t>(cells));
+        relax(static_cast<uint32_t>(source), source, 0, NO_PARENT, ARRIVED_ANY);
+        OpenEntry entry;
+        while (popOpen(entry)) {
+            int64_t cell = entry.node;
+            if (cell == target) return static_cast<int>(entry.g);
+            int row = static_cast<int>(cell / maze->columns);
+            int column = static_cast<int>(cell % maze->columns);
+            uint8_t arrivedBy = arrival[entry.node];
+            bool horizontal = arrivedBy == static_cast<uint8_t>(Direction::LEFT) || arrivedBy == static_cast<uint8_t>(Direction::RIGHT);
+            for (int d = 0; d < directionSize; ++d) {
+                bool dVertical = d == static_cast<int>(Direction::UP) || d == static_cast<int>(Direction::DOWN);
+                if (arrivedBy < directionSize) {
+                    if (d == (arrivedBy + 2) % directionSize) continue; // Never straight back
+                    // After a horizontal move only straight on or a forced side turn is canonical
+                    if (horizontal && dVertical && !forcedSide(row, column, arrivedBy, d)) continue;
+                }
+                int64_t next = dVertical ? jumpVertical(row, column, d) : jumpHorizontal(row, column, d);
+                if (next < 0) continue;
+                uint32_t distance = manhattan(cell, next, maze->columns);
+                relax(static_cast<uint32_t>(next), next, entry.g + distance, entry.node, static_cast<uint8_t>(d));
+            }
+            int64_t partner = portals ? maze->portalPartner(cell) : -1;
+            if (partner >= 0) relax(static_cast<uint32_t>(partner), partner, entry.g, entry.node, ARRIVED_PORTAL);
+        }
+        return -1;
+    }
+
+    // Walks the parents back from the target; jump-point segments are straight
+    // lines and are filled in cell by cell
+    void buildPath(uint32_t targetNode, std::vector<int64_t>& path) const {
+        path.clear();
+        for (uint32_t node = targetNode; node != NO_PARENT; node = parent[node]) {
+            int64_t cell = node % cells;
+            path.push_back(cell);
+            uint32_t from = parent[node];
+            if (from == NO_PARENT || arrival[node] >= directionSize) continue;
+            int64_t fromCell = from % cells;
+            int64_t step = columnStep(arrival[node]) + static_cast<int64_t>(rowStep(arrival[node])) * maze->columns;
+            for (int64_t between = cell - step; between != fromCell; between -= step) path.push_back(between);
+        }
+        std::reverse(path.begin(), path.end());
+    }
+
+public:
+    // Number of moves from source to target (row-major cells), or -1 when it
+    // cannot be reached. path, when given, receives every cell on the way
+    // including both ends; a portal hop shows up as two non-adjacent cells.
+    int find(const MazeView& view, int64_t source, int64_t goal, std::vector<int64_t>* path = nullptr,
+             bool usePortals = true, int wallJumps = 0, Method method = Method::ASTAR) {
+        maze = &view;
+        cells = static_cast<int64_t>(view.rows) * view.columns;
+        if (path) path->clear();
+        if (source < 0 || goal < 0 || source >= cells || goal >= cells) return -1;
+        target = goal;
+        targetRow = static_cast<int>(goal / view.columns);
+        targetColumn = static_cast<int>(goal % view.columns);
+        portals = usePortals && view.hasPortals();
+        if (portals) {
+            const auto& partners = view.features->portalPartners;
+            exitToTarget = view.rows + view.columns;
+            for (const auto& [end, partner] : partners) exitToTarget = std::min(exitToTarget, manhattan(partner, goal, view.columns));
+            portalEnds = 0;
+            if (partners.size() <= PATH_HEURISTIC_PORTAL_ENDS) {
+                for (const auto& [end, partner] : partners) {
+                    portalRow[portalEnds] = static_cast<int>(end / view.columns);
+                    portalColumn[portalEnds] = static_cast<int>(end % view.columns);
+                    portalToTarget[portalEnds++] = partners.size() == 2 ? manhattan(partner, goal, view.columns) : exitToTarget;
+                }
+                exitToTarget = view.rows + view.columns; // The per-end terms are at least as tight
+            }
+        }
+        wallJumps = std::max(0, wallJumps);
+
+        int length = method == Method::JUMP_POINT && wallJumps == 0 ? searchJumpPoint(source) : searchAStar(source, wallJumps);
+        if (length >= 0 && path) {
+            // The target may have been reached in any jump layer; the closed one is the answer
+            uint32_t targetNode = static_cast<uint32_t>(goal);
+            for (int layer = 0; layer <= wallJumps && closedStamp[targetNode] != stamp; ++layer) {
+                targetNode = static_cast<uint32_t>(layer * cells + goal);
+            }
+            buildPath(targetNode, *path);
+        }
+        return length;
+    }
+
+    // Nodes taken off the open list by the last query
+    size_t getExpandedNodes() const {
+        return expanded;
+    }
+};
+
+// Where each move ends, per cell and Direction, with the board edge, walls
+// and portals already resolved, so a move is one lookup. Entries are the
+// row-major cell the piece ends on, with MOVE_BLOCKED set when it stayed put
+// and MOVE_TELEPORTED when it left through a portal (it then landed on the
+// partner of that cell). open stops at walls; jump goes through inner walls
+// for JUMP_WALL and only stops at the edge. nodeMatrix keeps the table in
+// step with the maze, refreshing only the cells around a changed wall or portal.
+struct MoveTable {
+    static constexpr uint32_t MOVE_BLOCKED = 1U << 31;
+    static constexpr uint32_t MOVE_TELEPORTED = 1U << 30;
+    static constexpr uint32_t MOVE_CELL = MOVE_TELEPORTED - 1; // Boards up to 2^30 cells
+
+    std::vector<uint32_t> open; // [cell * directionSize + Direction]
+    std::vector<uint32_t> jump;
+    int columns = 0;
+
+    bool empty() const {
+        return open.empty();
+    }
+
+    void clear() {
+        open.clear();
+        jump.clear();
+    }
+
+    // Cell one step away, without checking the edge
+    int64_t step(int64_t from, int direction) const {
+        switch (static_cast<Direction>(direction)) {
+            case Direction::UP: return from - columns;
+            case Direction::DOWN: return from + columns;
+            case Direction::LEFT: return from - 1;
+            case Direction::RIGHT: return from + 1;
+        }
+        return from;
+    }
+
+    // The cell a move stepped onto, before any portal took the piece away
+    int64_t landing(int64_t from, int direction, uint32_t entry) const {
+        return (entry & MOVE_BLOCKED) ? from : step(from, direction);
+    }
+
+    void build(const MazeView& maze) {
+        columns = maze.columns;
+        size_t cells = static_cast<size_t>(maze.rows) * maze.columns;
+        open.resize(cells * directionSize);
+        jump.resize(cells * directionSize);
+        const uint8_t* flags = maze.features ? maze.features->flags.data() : nullptr;
+        for (int row = 0; row < maze.rows; ++row) {
+            for (int column = 0; column < maze.columns; ++column) fillCell(maze, flags, row, column);
+        }
+    }
+
+    // Recomputes the moves out of one cell
+    void refreshCell(const MazeView& maze, int row, int column) {
+        fillCell(maze, maze.features ? maze.features->flags.data() : nullptr, row, column);
+    }
+
+    // Recomputes every entry that can end on (row, column): its own and its neighbours'
+    void refreshAround(const MazeView& maze, int row, int column) {
+        refreshCell(maze, row, column);
+        if (row > 0) refreshCell(maze, row - 1, column);
+        if (row + 1 < maze.rows) refreshCell(maze, row + 1, column);
+        if (column > 0) refreshCell(maze, row, column - 1);
+        if (column + 1 < maze.columns) refreshCell(maze, row, column + 1);
+    }
+
+    // Entry for not moving at all (an invalid action): portals still apply
+    static uint32_t stayEntry(const MazeView& maze, int64_t cell) {
+        return resolve(maze, maze.features ? maze.features->flags.data() : nullptr, cell) | MOVE_BLOCKED;
+    }
+
+private:
+    // The cell a piece stepping onto cell ends on; flags is null for a bare maze
+    static uint32_t resolve(const MazeView& maze, const uint8_t* flags, int64_t cell) {
+        if (!flags || !(flags[cell] & CELL_PORTAL)) return static_cast<uint32_t>(cell);
+        return static_cast<uint32_t>(maze.portalPartner(cell)) | MOVE_TELEPORTED;
+    }
+
+    // Reads the wall bits directly; the edge and the padding past the last
+    // column are walls in the planes
+    void fillCell(const MazeView& maze, const uint8_t* flags, int row, int column) {
+        int64_t from = static_cast<int64_t>(row) * maze.columns + column;
+        size_t word = static_cast<size_t>(row) * maze.wordsPerRow + (column >> 6);
+        int bit = column & 63;
+        uint32_t stay = resolve(maze, flags, from) | MOVE_BLOCKED;
+        uint32_t up = row > 0 ? resolve(maze, flags, from - maze.columns) : stay;
+        uint32_t down = row + 1 < maze.rows ? resolve(maze, flags, from + maze.columns) : stay;
+        uint32_t left = column > 0 ? resolve(maze, flags, from - 1) : stay;
+        uint32_t right = column + 1 < maze.columns ? resolve(maze, flags, from + 1) : stay;
+        bool northWall = row == 0 || ((maze.southWalls[word - maze.wordsPerRow] >> bit) & 1);
+        bool southWall = (maze.southWalls[word] >> bit) & 1;
+        bool westWall = column == 0 || ((maze.eastWalls[word - (bit == 0)] >> ((column - 1) & 63)) & 1);
+        bool eastWall = (maze.eastWalls[word] >> bit) & 1;
+
+        uint32_t* jumpMoves = &jump[from * directionSize];
+        jumpMoves[static_cast<int>(Direction::UP)] = up;
+        jumpMoves[static_cast<int>(Direction::RIGHT)] = right;
+        jumpMoves[static_cast<int>(Direction::DOWN)] = down;
+        jumpMoves[static_cast<int>(Direction::LEFT)] = left;
+        uint32_t* openMoves = &open[from * directionSize];
+        openMoves[static_cast<int>(Direction::UP)] = northWall ? stay : up;
+        openMoves[static_cast<int>(Direction::RIGHT)] = eastWall ? stay : right;
+        openMoves[static_cast<int>(Direction::DOWN)] = southWall ? stay : down;
+        openMoves[static_cast<int>(Direction::LEFT)] = westWall ? stay : left;
+    }
+};
+
+// Everything about a match that does not change while it is played: the
+// maze with its portals and pickups, and where the treasure is. Game states
+// point at one of these, so copying a position never copies the maze. It
+// also holds the Zobrist keys; piece and pickup keys are derived on the fly,
+// so big boards need no key table.
+struct GameBoard {
+    MazeView maze = {};
+    const MoveTable* moves = nullptr;
+    int64_t treasureCell = -1;
+    uint64_t zobristSeed = 0;
+    uint64_t powerKeys[2][2][4] = {}; // [player][armed][PowerType]
+    uint64_t toMoveKey = 0;           // Set while player 2 is to move
+    uint64_t winnerKeys[2] = {};
+
+    void setZobristSeed(uint64_t seed) {
+        zobristSeed = seed;
+        uint64_t stream = 0;
+        for (auto& player : powerKeys) {
+            for (auto& armed : player) {
+                for (uint64_t& key : armed) key = Rng::mix(~seed, stream++);
+            }
+        }
+        toMoveKey = Rng::mix(~seed, stream++);
+        winnerKeys[0] = Rng::mix(~seed, stream++);
+        winnerKeys[1] = Rng::mix(~seed, stream++);
+    }
+
+    // Two multiply-xorshift rounds of the cell: cheap enough to run per move
+    uint64_t pieceKey(int player, int64_t cell) const {
+        uint64_t z = (static_cast<uint64_t>(cell) * 2 + player + 1) * 0x9E3779B97F4A7C15ULL ^ zobristSeed;
+        z = (z ^ (z >> 32)) * 0xD6E8FEB86659FD93ULL;
+        return z ^ (z >> 32);
+    }
+
+    // Set while pickup slot is taken; negative cells never collide with piece keys
+    uint64_t pickupKey(int slot) const {
+        return pieceKey(0, -1 - static_cast<int64_t>(slot));
+    }
+};
+
+// Actions a turn is made of, indexed by Direction; the last one is USE_POWER
+const int GAME_ACTION_COUNT = directionSize + 1;
+const char gameActions[GAME_ACTION_COUNT] = {'W', 'D', 'S', 'A', USE_POWER};
+
+// All mutable match state in 48 trivially copyable bytes: piece cells, held
+// and armed powers, which pickups are gone, whose turn it is and the winner.
+// apply() follows the same rules as nodeMatrix::takeTurn and keeps the
+// Zobrist hash up to date, so a search can copy, step and hash positions
+// without touching the heap.
+struct GameState {
+    const GameBoard* board;
+    uint64_t hash;
+    uint64_t pickupsTaken;    // Bit per pickup slot
+    int32_t cell[2];          // Row-major cells, indexed by PlayerTurn
+    uint8_t held[2];          // PowerType picked up and not used yet
+    uint8_t active[2];        // PowerType armed for the next move
+    uint8_t toMove;           // PlayerTurn
+    int8_t winner;            // PlayerTurn, -1 while the match goes on
+    uint32_t ply;             // Actions applied since the state was taken
+
+    PowerType heldPower(int player) const {
+        return static_cast<PowerType>(held[player]);
+    }
+
+    PowerType activePower(int player) const {
+        return static_cast<PowerType>(active[player]);
+    }
+
+    // Direction of a move action, -1 for anything else
+    static int directionOf(char action) {
+        switch (action) {
+            case 'W': return static_cast<int>(Direction::UP);
+            case 'D': return static_cast<int>(Direction::RIGHT);
+            case 'S': return static_cast<int>(Direction::DOWN);
+            case 'A': return static_cast<int>(Direction::LEFT);
+            default: return -1;
+        }
+    }
+
+    // The piece the next move goes to: the opponent's while CONTROL_ENEMY is armed
+    int controlledPiece() const {
+        return activePower(toMove) == PowerType::CONTROL_ENEMY ? 1 - toMove : toMove;
+    }
+
+    uint64_t computeHash() const {
+        uint64_t h = board->pieceKey(0, cell[0]) ^ board->pieceKey(1, cell[1]);
+        for (int p = 0; p < 2; ++p) {
+            h ^= board->powerKeys[p][0][held[p]] ^ board->powerKeys[p][1][active[p]];
+        }
+        if (toMove) h ^= board->toMoveKey;
+        for (uint64_t taken = pickupsTaken; taken; taken &= taken - 1) h ^= board->pickupKey(__builtin_ctzll(taken));
+        if (winner >= 0) h ^= board->winnerKeys[winner];
+        return h;
+    }
+
+    // MoveTable entry for moving the piece: through an inner wall while
+    // JUMP_WALL is armed. Only a cell when the move is not blocked.
+    uint32_t moveEntry(int piece, int direction) const {
+        size_t index = static_cast<size_t>(cell[piece]) * directionSize + direction;
+        uint32_t entry = board->moves->open[index];
+        if ((entry & MoveTable::MOVE_BLOCKED) && activePower(piece) == PowerType::JUMP_WALL) entry = board->moves->jump[index];
+        return entry;
+    }
+
+    // Actions that change the position: open moves (through inner walls too
+    // with JUMP_WALL armed) and USE_POWER while a power is held. Returns the count.
+    int legalActions(char actions[GAME_ACTION_COUNT]) const {
+        int count = 0;
+        int piece = controlledPiece();
+        for (int d = 0; d < directionSize; ++d) {
+            if (!(moveEntry(piece, d) & MoveTable::MOVE_BLOCKED)) actions[count++] = gameActions[d];
+        }
+        if (held[toMove] != static_cast<uint8_t>(PowerType::NONE)) actions[count++] = USE_POWER;
+        return count;
+    }
+
+    // Plays one action for the player to move, like nodeMatrix::takeTurn.
+    // Returns true when the same player acts again.
+    bool apply(char action) {
+        int me = toMove;
+        ++ply;
+        if (action == USE_POWER) {
+            if (held[me] == static_cast<uint8_t>(PowerType::NONE)) return true;
+            setActive(me, held[me]);
+            setHeld(me, static_cast<uint8_t>(PowerType::NONE));
+            return true;
+        }
+        int direction = directionOf(action);
+        int piece = controlledPiece();
+        if (piece != me) setActive(me, static_cast<uint8_t>(PowerType::NONE));
+        const MoveTable& moves = *board->moves;
+        int64_t from = cell[piece];
+        uint32_t entry;
+        if (direction < 0) {
+            entry = MoveTable::stayEntry(board->maze, from);
+        } else {
+            size_t index = static_cast<size_t>(from) * directionSize + direction;
+            entry = moves.open[index];
+            if ((entry & MoveTable::MOVE_BLOCKED) && activePower(piece) == PowerType::JUMP_WALL &&
+                !(moves.jump[index] & MoveTable::MOVE_BLOCKED)) {
+                setActive(piece, static_cast<uint8_t>(PowerType::NONE));
+                entry = moves.jump[index];
+            }
+        }
+
+        // The same checks as nodeMatrix::movePlayer, made even when the piece
+        // did not move: the treasure is looked for before a portal is taken
+        int64_t landing = moves.landing(from, direction, entry);
+        if (landing == board->treasureCell) {
+            if (landing != from) moveTo(piece, landing);
+            winner = static_cast<int8_t>(piece);
+            hash ^= board->winnerKeys[piece];
+            return false;
+        }
+        int64_t to = entry & MoveTable::MOVE_CELL;
+        if (to != from) moveTo(piece, to);
+        int slot = held[piece] == static_cast<uint8_t>(PowerType::NONE) ? board->maze.pickupSlot(cell[piece]) : -1;
+        if (slot >= 0 && !((pickupsTaken >> slot) & 1)) {
+            setHeld(piece, static_cast<uint8_t>(board->maze.features->pickupTypes[slot]));
+            pickupsTaken |= 1ULL << slot;
+            hash ^= board->pickupKey(slot);
+        }
+        if (activePower(me) == PowerType::DOUBLE_PLAY) {
+            setActive(me, static_cast<uint8_t>(PowerType::NONE));
+            return true;
+        }
+        toMove = static_cast<uint8_t>(1 - me);
+        hash ^= board->toMoveKey;
+        return false;
+    }
+
+private:
+    void moveTo(int piece, int64_t next) {
+        hash ^= board->pieceKey(piece, cell[piece]) ^ board->pieceKey(piece, next);
+        cell[piece] = static_cast<int32_t>(next);
+    }
+
+    void setHeld(int player, uint8_t power) {
+        hash ^= board->powerKeys[player][0][held[player]] ^ board->powerKeys[player][0][power];
+        held[player] = power;
+    }
+
+    void setActive(int player, uint8_t power) {
+        hash ^= board->powerKeys[player][1][active[player]] ^ board->powerKeys[player][1][power];
+        active[player] = power;
+    }
+};
+
+// Cells a distance field is kept from. PORTAL_A and PORTAL_B are the two ends
+// of the first portal pair only; later pairs have no field of their own.
+enum class DistanceSource { PLAYER1_START, PLAYER2_START, TREASURE, PORTAL_A, PORTAL_B };
+const int distanceSourceCount = 5;
+
+class nodeMatrix {
+private:
+    // Cells are stored row-major in flat arrays (structure of arrays). A cell's
+    // info value is its row-major index, so it is derived instead of stored.
+    // Visited and wall state are bit planes with wordsPerRow 64-bit words per row.
+    int nodeRows;
+    int nodeColumns;
+    int wordsPerRow;
+    std::vector<uint64_t> visitedBits;
+    std::vector<uint64_t> eastWallBits;  // Wall between (row, col) and (row, col + 1)
+    std::vector<uint64_t> southWallBits; // Wall between (row, col) and (row + 1, col)
+    FeatureIndex features;
+    MoveTable moveTable;          // Built on first use, then kept in step with the maze
+    uint64_t topologyVersion = 0; // Bumped whenever walls or portals change
+    DistanceField distanceFields[distanceSourceCount];
+    uint64_t distanceVersions[distanceSourceCount] = {};
+    int64_t distanceSources[distanceSourceCount] = {};
+    PathFinder pathFinder;
+    GameBoard gameBoard;
+    uint64_t seed;
+    uint64_t mazeSeed = 0;  // Arguments of the last generateMaze, for replays
+    double mazeBraid = 0;
+    bool mazeCarved = false;
+    Rng rng;
+    EventRing events;
+    std::vector<Portal> portals;
+    std::vector<Power> powers;   // Index is the pickup slot; taken pickups stay listed
+    Treasure treasure;  // Include treasure in nodeMatrix
+    // Scratch kept between calls, so a reused board allocates nothing
+    CellMap<int64_t> previousPartners; // markFeatures: the pairing before the rebuild
+    std::vector<int64_t> pickedCells;   // spawnFeatures
+    std::vector<uint64_t> pickedBits;
+    std::vector<uint8_t> blocksJoined;  // joinBlocks
+    std::vector<std::pair<int, int>> blockPath;
+
+    void initializeMatrix(int nodeRows, int nodeColumns) {
+        this->nodeRows = nodeRows;
+        this->nodeColumns = nodeColumns;
+        wordsPerRow = (nodeColumns + 63) / 64;
+        size_t words = static_cast<size_t>(nodeRows) * wordsPerRow;
+        visitedBits.assign(words, 0);
+        eastWallBits.assign(words, 0);
+        southWallBits.assign(words, 0);
+        features.flags.assign(static_cast<size_t>(nodeRows) * nodeColumns, 0);
+        moveTable.clear();
+        closeBoundary();
+    }
+
+    // The outer edge is stored as walls so neighbour checks never leave the board.
+    // Bits past the last column are kept set as well.
+    void closeBoundary() {
+        int lastBit = (nodeColumns - 1) % 64;
+        uint64_t padding = ~0ULL << lastBit;
+        for (int i = 0; i < nodeRows; ++i) {
+            eastWallBits[static_cast<size_t>(i) * wordsPerRow + wordsPerRow - 1] |= padding;
+        }
+        if (nodeRows > 0) {
+            for (int w = 0; w < wordsPerRow; ++w) {
+                southWallBits[static_cast<size_t>(nodeRows - 1) * wordsPerRow + w] = ~0ULL;
+            }
+        }
+    }
+
+    static bool testBit(const std::vector<uint64_t>& bits, size_t word, int col) {
+        return (bits[word] >> (col & 63)) & 1ULL;
+    }
+
+    static void assignBit(std::vector<uint64_t>& bits, size_t word, int col, bool value) {
+        uint64_t mask = 1ULL << (col & 63);
+        if (value) bits[word] |= mask;
+        else bits[word] &= ~mask;
+    }
+
+    size_t wordIndex(int row, int column) const {
+        return static_cast<size_t>(row) * wordsPerRow + (column >> 6);
+    }
+
+    // Records an event at the player's current position. Builds with
+    // MAZE_NO_EVENTS compile this away together with the event construction.
+    void emit(GameEventType type, const Player& player, char direction, PowerType power = PowerType::NONE) {
+#ifdef MAZE_NO_EVENTS
+        (void)type, (void)player, (void)direction, (void)power;
+#else
+        std::pair<int, int> position = player.getCurrentPosition();
+        events.push({type, player.getTurn(), power, direction, position.first, position.second});
+#endif
+    }
+
+    // An armed JUMP_WALL takes the player through the wall in front of them
+    bool jumpWall(Player& player) {
+        if (player.getActivePower() != PowerType::JUMP_WALL) return false;
+        player.setActivePower(PowerType::NONE);
+        return true;
+    }
+
+    // True when field i no longer matches the maze; records what it is rebuilt for
+    bool claimStaleField(int i) {
+        int64_t source = sourceCell(static_cast<DistanceSource>(i));
+        if (distanceVersions[i] == topologyVersion && distanceSources[i] == source) return false;
+        distanceVersions[i] = topologyVersion;
+        distanceSources[i] = source;
+        return true;
+    }
+
+    // Rebuilds the feature index from the portal, pickup and treasure lists
+    void markFeatures() {
+        ++topologyVersion;
+        size_t cells = static_cast<size_t>(nodeRows) * nodeColumns;
+        previousPartners.swap(features.portalPartners);
+        features.portalPartners.clear();
+        std::fill(features.flags.begin(), features.flags.end(), 0);
+        features.portalBits.assign(visitedBits.size(), 0);
+        features.pickupBits.assign((cells + 63) / 64, 0);
+        features.pickupSlots.clear();
+        features.pickupTypes.clear();
+        auto mark = [this](const std::pair<int, int>& pos, uint8_t flag) {
+            if (isInside(pos.first, pos.second)) {
+                features.flags[cellIndex(pos.first, pos.second)] |= flag;
+            }
+        };
+        for (const Portal& portal : portals) {
+            int64_t a = cellOf(portal.getPortalAPosition());
+            int64_t b = cellOf(portal.getPortalBPosition());
+            if (a < 0 || b < 0 || a == b) continue;
+            for (const auto& pos : {portal.getPortalAPosition(), portal.getPortalBPosition()}) {
+                mark(pos, CELL_PORTAL);
+                features.portalBits[wordIndex(pos.first, pos.second)] |= 1ULL << (pos.second & 63);
+            }
+            features.portalPartners.set(a, b);
+            features.portalPartners.set(b, a);
+        }
+        features.portalPartners.seal();
+        for (size_t slot = 0; slot < powers.size(); ++slot) {
+            int64_t cell = cellOf(powers[slot].getPosition());
+            features.pickupTypes.push_back(powers[slot].getPowerType());
+            if (cell < 0) continue;
+            if (powers[slot].isPowerPresent()) mark(powers[slot].getPosition(), CELL_POWER);
+            features.pickupBits[cell >> 6] |= 1ULL << (cell & 63);
+            features.pickupSlots.set(cell, static_cast<uint32_t>(slot));
+        }
+        features.pickupSlots.seal();
+        mark(treasure.getPosition(), CELL_TREASURE);
+        refreshPortalMoves();
+    }
+
+    // Refreshes the moves into every portal cell that was added, removed or re-paired
+    void refreshPortalMoves() {
+        if (moveTable.empty()) return;
+        MazeView view = getView();
+        auto refresh = [&](int64_t cell) {
+            moveTable.refreshAround(view, static_cast<int>(cell / nodeColumns), static_cast<int>(cell % nodeColumns));
+        };
+        for (const auto& entry : previousPartners) {
+            auto now = features.portalPartners.find(entry.first);
+            if (now == features.portalPartners.end() || now->second != entry.second) refresh(entry.first);
+        }
+        for (const auto& entry : features.portalPartners) {
+            if (!previousPartners.count(entry.first)) refresh(entry.first);
+        }
+    }
+
+    PowerType randomPowerType() {
+        return static_cast<PowerType>(1 + rng.nextBelow(3)); // Any PowerType except NONE
+    }
+
+public:
+    // Everything random about the match is drawn from one engine seeded with seed
+    nodeMatrix(int nodeRows, int nodeColumns, uint64_t seed = Rng::randomSeed()) {
+        reset(nodeRows, nodeColumns, seed);
+    }
+
+    // Turns this into nodeMatrix(nodeRows, nodeColumns, seed), keeping the
+    // buffers: a board recycled at the same size or smaller allocates nothing.
+    void reset(int nodeRows, int nodeColumns, uint64_t seed) {
+        this->seed = seed;
+        rng.reseed(seed);
+        mazeSeed = 0;
+        mazeBraid = 0;
+        mazeCarved = false;
+        events.clear();
+        initializeMatrix(nodeRows, nodeColumns);
+        spawnFeatures(DEFAULT_PORTAL_PAIRS, DEFAULT_POWER_PICKUPS);
+        treasure.placeTreasureEquidistant(rng, nodeRows, nodeColumns, getPlayer1Start(), getPlayer2Start());
+        markFeatures();
+        gameBoard.setZobristSeed(Rng::mix(seed, 0x5A0B));
+    }
+
+    std::pair<int, int> getPlayer1Start() const {
+        return std::make_pair(startRow, startColumn);
+    }
+
+    std::pair<int, int> getPlayer2Start() const {
+        return std::make_pair(nodeRows - 1 - startRow, nodeColumns - 1 - startColumn);
+    }
+
+    uint64_t getSeed() const {
+        return seed;
+    }
+
+    uint64_t getMazeSeed() const {
+        return mazeSeed;
+    }
+
+    double getMazeBraid() const {
+        return mazeBraid;
+    }
+
+    bool isMazeCarved() const {
+        return mazeCarved;
+    }
+
+    // Fingerprint of the walls and portals. Replays store it to notice when a
+    // seed no longer builds the board it was recorded on.
+    uint64_t getMazeChecksum() const {
+        uint64_t h = Rng::mix(static_cast<uint64_t>(nodeRows), static_cast<uint64_t>(nodeColumns));
+        for (size_t i = 0; i < eastWallBits.size(); ++i) {
+            h = Rng::mix(h ^ eastWallBits[i], southWallBits[i]);
+        }
+        for (const Portal& portal : portals) {
+            h = Rng::mix(h, static_cast<uint64_t>(cellOf(portal.getPortalAPosition())));
+            h = Rng::mix(h, static_cast<uint64_t>(cellOf(portal.getPortalBPosition())));
+        }
+        return h;
+    }
+
+    // Changes whenever walls, portals or other features change; lets views cache the board
+    uint64_t getTopologyVersion() const {
+        return topologyVersion;
+    }
+
+    Rng& getRng() {
+        return rng;
+    }
+
+    int getRows() const {
+        return nodeRows;
+    }
+
+    int getColumns() const {
+        return nodeColumns;
+    }
+
+    bool isInside(int row, int column) const {
+        return row >= 0 && row < nodeRows && column >= 0 && column < nodeColumns;
+    }
+
+    size_t cellIndex(int row, int column) const {
+        return static_cast<size_t>(row) * nodeColumns + column;
+    }
+
+    nodeCell getNode(int row, int column) const {
+        return nodeCell(static_cast<int>(cellIndex(row, column)), isVisited(row, column));
+    }
+
+    bool isVisited(int row, int column) const {
+        return testBit(visitedBits, wordIndex(row, column), column);
+    }
+
+    void setVisited(int row, int column, bool value) {
+        assignBit(visitedBits, wordIndex(row, column), column, value);
+    }
+
+    void clearVisited() {
+        std::fill(visitedBits.begin(), visitedBits.end(), 0);
+    }
+
+    // Walls are shared between neighbours: UP/LEFT are read from the cell above/left.
+    // Moving off the board always counts as a wall.
+    bool hasWall(int row, int column, Direction direction) const {
+        switch (direction) {
+            case Direction::UP:
+                return row == 0 || testBit(southWallBits, wordIndex(row - 1, column), column);
+            case Direction::DOWN:
+                return testBit(southWallBits, wordIndex(row, column), column);
+            case Direction::LEFT:
+                return column == 0 || testBit(eastWallBits, wordIndex(row, column - 1), column - 1);
+            case Direction::RIGHT:
+                return testBit(eastWallBits, wordIndex(row, column), column);
+        }
+        return true;
+    }
+
+    // Boundary walls cannot be removed
+    void setWall(int row, int column, Direction direction, bool value) {
+        ++topologyVersion;
+        switch (direction) {
+            case Direction::UP:
+                if (row > 0) assignBit(southWallBits, wordIndex(row - 1, column), column, value);
+                break;
+            case Direction::DOWN:
+                if (row < nodeRows - 1) assignBit(southWallBits, wordIndex(row, column), column, value);
+                break;
+            case Direction::LEFT:
+                if (column > 0) assignBit(eastWallBits, wordIndex(row, column - 1), column - 1, value);
+                break;
+            case Direction::RIGHT:
+                if (column < nodeColumns - 1) assignBit(eastWallBits, wordIndex(row, column), column, value);
+                break;
+        }
+        // Only the moves across this wall change, from either side
+        if (!moveTable.empty() && isInside(row, column)) {
+            int nextRow = row + (direction == Direction::DOWN) - (direction == Direction::UP);
+            int nextColumn = column + (direction == Direction::RIGHT) - (direction == Direction::LEFT);
+            moveTable.refreshCell(getView(), row, column);
+            if (isInside(nextRow, nextColumn)) moveTable.refreshCell(getView(), nextRow, nextColumn);
+        }
+    }
+
+    uint8_t getFeatures(int row, int column) const {
+        return features.flags[cellIndex(row, column)];
+    }
+
+    // Pickup still lying on the cell, NONE when there is none
+    PowerType getPowerAt(int row, int column) const {
+        int64_t cell = static_cast<int64_t>(cellIndex(row, column));
+        if (!(features.flags[cell] & CELL_POWER)) return PowerType::NONE;
+        return features.pickupTypes[features.pickupSlots.find(cell)->second];
+    }
+
+    // The other end of a portal on the cell, or (-1, -1)
+    std::pair<int, int> getPortalExit(int row, int column) const {
+        int64_t partner = getView().portalPartner(static_cast<int64_t>(cellIndex(row, column)));
+        return partner < 0 ? std::make_pair(-1, -1) : std::make_pair(static_cast<int>(partner / nodeColumns), static_cast<int>(partner % nodeColumns));
+    }
+
+    // Row-major index of pos, or -1 off the board
+    int64_t cellOf(const std::pair<int, int>& pos) const {
+        return isInside(pos.first, pos.second) ? static_cast<int64_t>(cellIndex(pos.first, pos.second)) : -1;
+    }
+
+    MazeView getView() const {
+        return {nodeRows, nodeColumns, wordsPerRow, eastWallBits.data(), southWallBits.data(), &features};
+    }
+
+    // Path lengths from (row, column) through the maze, one entry per cell in
+    // row-major order; -1 marks unreachable cells
+    void computeDistances(int row, int column, std::vector<int>& distances) const {
+        DistanceField field;
+        field.compute(getView(), {static_cast<int64_t>(cellIndex(row, column))});
+        distances = field.getDistances();
+    }
+
+    // Cached distance map from a player start, the treasure or a portal end.
+    // It is only rebuilt after walls or portals changed or its source moved,
+    // so asking every turn is free while the maze stays the same.
+    const DistanceField& getDistanceField(DistanceSource source) {
+        int i = static_cast<int>(source);
+        if (claimStaleField(i)) distanceFields[i].compute(getView(), &distanceSources[i], 1);
+        return distanceFields[i];
+    }
+
+    // Stands in a precomputed map for the cached one, as if getDistanceField
+    // had just computed it for the board as it is now
+    void setDistanceField(DistanceSource source, const int32_t* distances) {
+        int i = static_cast<int>(source);
+        claimStaleField(i);
+        distanceFields[i].assign(getView(), distances);
+    }
+
+    // Per-cell move destinations; built on the first call after the maze was
+    // (re)generated, patched in place by setWall and feature changes
+    const MoveTable& getMoveTable() {
+        if (moveTable.empty()) moveTable.build(getView());
+        return moveTable;
+    }
+
+    // The fixed part of the match for GameState; refreshed on every call, at
+    // the same address, so states taken earlier keep pointing at it
+    const GameBoard& getGameBoard() {
+        gameBoard.maze = getView();
+        gameBoard.moves = &getMoveTable();
+        gameBoard.treasureCell = cellOf(treasure.getPosition());
+        return gameBoard;
+    }
+
+    // Copies the match into a GameState with toMove to act next
+    GameState snapshot(const Player& player1, const Player& player2, PlayerTurn toMove) {
+        GameState state = {};
+        state.board = &getGameBoard();
+        for (const Player* player : {&player1, &player2}) {
+            int p = static_cast<int>(player->getTurn());
+            state.cell[p] = static_cast<int32_t>(cellOf(player->getCurrentPosition()));
+            state.held[p] = static_cast<uint8_t>(player->getHeldPower());
+            state.active[p] = static_cast<uint8_t>(player->getActivePower());
+            if (player->getHasWon()) state.winner = static_cast<int8_t>(p);
+        }
+        if (!player1.getHasWon() && !player2.getHasWon()) state.winner = -1;
+        state.toMove = static_cast<uint8_t>(toMove);
+        for (size_t slot = 0; slot < powers.size(); ++slot) {
+            if (!powers[slot].isPowerPresent()) state.pickupsTaken |= 1ULL << slot;
+        }
+        state.hash = state.computeHash();
+        return state;
+    }
+
+    // Puts a GameState of this board back onto the players and the pickups
+    void restore(const GameState& state, Player& player1, Player& player2) {
+        for (Player* player : {&player1, &player2}) {
+            int p = static_cast<int>(player->getTurn());
+            player->setCurrentPosition({state.cell[p] / nodeColumns, state.cell[p] % nodeColumns});
+            player->setHeldPower(state.heldPower(p));
+            player->setActivePower(state.activePower(p));
+            player->setHasWon(state.winner == p);
+        }
+        for (size_t slot = 0; slot < powers.size(); ++slot) {
+            Power& pickup = powers[slot];
+            bool taken = (state.pickupsTaken >> slot) & 1;
+            if (taken != pickup.isPowerPresent() || !isInside(pickup.getPosition().first, pickup.getPosition().second)) continue;
+            if (taken) pickup.consume();
+            else pickup.placePower(pickup.getPosition(), pickup.getPowerType());
+            features.flags[cellOf(pickup.getPosition())] ^= CELL_POWER;
+        }
+    }
+
+    // Shortest number of moves between two cells, or -1 when there is no way.
+    // wallJumps is how many walls the path may cross (PowerType::JUMP_WALL);
+    // path, when given, is filled with the row-major cells along the way.
+    int findPath(const std::pair<int, int>& from, const std::pair<int, int>& to, std::vector<int64_t>* path = nullptr,
+                 bool usePortals = true, int wallJumps = 0, PathFinder::Method method = PathFinder::Method::ASTAR) {
+        if (!isInside(from.first, from.second) || !isInside(to.first, to.second)) {
+            if (path) path->clear();
+            return -1;
+        }
+        return pathFinder.find(getView(), static_cast<int64_t>(cellIndex(from.first, from.second)),
+                               static_cast<int64_t>(cellIndex(to.first, to.second)), path, usePortals, wallJumps, method);
+    }
+
+    // Rebuilds every stale distance map, one per thread
+    void refreshDistanceFields() {
+        int stale[distanceSourceCount];
+        int count = 0;
+        for (int i = 0; i < distanceSourceCount; ++i) {
+            if (claimStaleField(i)) stale[count++] = i;
+        }
+        MazeView view = getView();
+        parallelFor(count, [&](int k) {
+            distanceFields[stale[k]].compute(view, {distanceSources[stale[k]]});
+        });
+    }
+
+    // Cell of source, or -1 when it is not on the board. The portal sources
+    // follow portals[0]; other pairs are not covered.
+    int64_t sourceCell(DistanceSource source) const {
+        std::pair<int, int> pos;
+        switch (source) {
+            case DistanceSource::PLAYER1_START: pos = getPlayer1Start(); break;
+            case DistanceSource::PLAYER2_START: pos = getPlayer2Start(); break;
+            case DistanceSource::TREASURE: pos = treasure.getPosition(); break;
+            case DistanceSource::PORTAL_A: pos = portals.empty() ? std::make_pair(-1, -1) : portals[0].getPortalAPosition(); break;
+            case DistanceSource::PORTAL_B: pos = portals.empty() ? std::make_pair(-1, -1) : portals[0].getPortalBPosition(); break;
+        }
+        return isInside(pos.first, pos.second) ? static_cast<int64_t>(cellIndex(pos.first, pos.second)) : -1;
+    }
+
+    // Re-rolls the treasure so both players are equally far from it: through
+    // the maze with usePathDistance, by Manhattan distance otherwise. Returns
+    // false, leaving no treasure on the board, when no such cell exists.
+    bool placeTreasure(bool usePathDistance) {
+        bool placed;
+        if (usePathDistance) {
+            placed = treasure.placeTreasurePathEquidistant(rng, nodeColumns,
+                                                           getDistanceField(DistanceSource::PLAYER1_START).getDistances(),
+                                                           getDistanceField(DistanceSource::PLAYER2_START).getDistances());
+        } else {
+            placed = treasure.placeTreasureEquidistant(rng, nodeRows, nodeColumns, getPlayer1Start(), getPlayer2Start());
+        }
+        markFeatures();
+        return placed;
+    }
+
+    Treasure& getTreasure() {
+        return treasure;
+    }
+
+    // Puts the treasure or a single power pickup on a given cell (scenarios,
+    // tests); setPower with PowerType::NONE leaves the board without pickups
+    void setTreasure(int row, int column) {
+        treasure.setPosition({row, column});
+        markFeatures();
+    }
+
+    void setPower(int row, int column, PowerType type) {
+        powers.clear();
+        if (!addPower(row, column, type)) markFeatures();
+    }
+
+    // Adds a pickup; false when the cell already has one, the type is NONE or
+    // the board holds MAX_POWER_PICKUPS
+    bool addPower(int row, int column, PowerType type) {
+        if (type == PowerType::NONE || powers.size() >= static_cast<size_t>(MAX_POWER_PICKUPS)) return false;
+        if (isInside(row, column) && getView().pickupSlot(static_cast<int64_t>(cellIndex(row, column))) >= 0) return false;
+        powers.emplace_back(std::make_pair(row, column), type);
+        markFeatures();
+        return true;
+    }
+
+    // Replaces every portal and pickup at once; pickups keep their order as slots
+    void setFeatures(const std::vector<Portal>& newPortals, const std::vector<Power>& newPowers) {
+        portals = newPortals;
+        powers.assign(newPowers.begin(), newPowers.begin() + std::min<size_t>(newPowers.size(), MAX_POWER_PICKUPS));
+        markFeatures();
+    }
+
+    void addPortal(const std::pair<int, int>& a, const std::pair<int, int>& b) {
+        portals.emplace_back(a, b);
+        markFeatures();
+    }
+
+    void clearPortals() {
+        portals.clear();
+        markFeatures();
+    }
+
+    // Replaces the portals and pickups with portalPairs pairs and powerPickups
+    // pickups of random types, on distinct cells other than the starts. All
+    // the cells are drawn together as one uniform sample (Floyd's algorithm,
+    // one draw per feature, so the board size does not matter) and shuffled
+    // before they are handed out, so no cell or role is favoured.
+    void spawnFeatures(int portalPairs, int powerPickups) {
+        int64_t excluded[2] = {cellOf(getPlayer1Start()), cellOf(getPlayer2Start())};
+        if (excluded[0] > excluded[1]) std::swap(excluded[0], excluded[1]);
+        if (excluded[0] == excluded[1]) excluded[0] = -1;
+        int64_t freeCells = static_cast<int64_t>(nodeRows) * nodeColumns - (excluded[0] >= 0) - (excluded[1] >= 0);
+        powerPickups = static_cast<int>(std::clamp<int64_t>(powerPickups, 0, std::min<int64_t>(MAX_POWER_PICKUPS, freeCells)));
+        portalPairs = static_cast<int>(std::clamp<int64_t>(portalPairs, 0, (freeCells - powerPickups) / 2));
+        int64_t needed = 2 * static_cast<int64_t>(portalPairs) + powerPickups;
+
+        // Floyd's sampling; every free index drawn so far has its bit set in taken
+        std::vector<int64_t>& picked = pickedCells;
+        std::vector<uint64_t>& taken = pickedBits;
+        picked.clear();
+        taken.assign(static_cast<size_t>(freeCells + 63) / 64, 0);
+        for (int64_t j = freeCells - needed; j < freeCells; ++j) {
+            int64_t t = static_cast<int64_t>(rng.next() % static_cast<uint64_t>(j + 1));
+            if ((taken[t >> 6] >> (t & 63)) & 1) t = j;
+            taken[t >> 6] |= 1ULL << (t & 63);
+            picked.push_back(t);
+        }
+        for (int64_t i = needed - 1; i > 0; --i) {
+            std::swap(picked[i], picked[rng.next() % static_cast<uint64_t>(i + 1)]);
+        }
+        // Free index to cell: step over the start cells
+        for (int64_t& cell : picked) {
+            for (int64_t skip : excluded) {
+                if (skip >= 0 && cell >= skip) ++cell;
+            }
+        }
+
+        auto position = [this](int64_t cell) {
+            return std::make_pair(static_cast<int>(cell / nodeColumns), static_cast<int>(cell % nodeColumns));
+        };
+        portals.clear();
+        powers.clear();
+        for (int p = 0; p < portalPairs; ++p) portals.emplace_back(position(picked[2 * p]), position(picked[2 * p + 1]));
+        for (int64_t i = 2 * static_cast<int64_t>(portalPairs); i < needed; ++i) powers.emplace_back(position(picked[i]), randomPowerType());
+        markFeatures();
+    }
+
+    const std::vector<Portal>& getPortals() const {
+        return portals;
+    }
+
+    // Every pickup the match started with, in slot order; taken ones are no longer present
+    const std::vector<Power>& getPowers() const {
+        return powers;
+    }
+
+    // Carves a perfect maze, then knocks out each remaining inner wall with
+    // probability extraEdgeProb to add loops. The board is split into
+    // MAZE_BLOCK_SIZE square blocks that are carved independently with an
+    // iterative depth-first search, so the working set stays in cache and the
+    // blocks can be spread over all cores. The blocks are then joined by one
+    // door per edge of a depth-first spanning tree over the block grid. Every
+    // block and row band draws from its own stream derived from the seed, so
+    // the maze depends only on the seed and not on the thread count.
+    void generateMaze(uint64_t seed, double extraEdgeProb = EXTRA_EDGE_PROB) {
+        ++topologyVersion;
+        mazeSeed = seed;
+        mazeBraid = extraEdgeProb;
+        mazeCarved = true;
+        moveTable.clear(); // Every wall changes; rebuilt whole on the next move
+        std::fill(eastWallBits.begin(), eastWallBits.end(), ~0ULL);
+        std::fill(southWallBits.begin(), southWallBits.end(), ~0ULL);
+
+        int blockRows = (nodeRows + MAZE_BLOCK_SIZE - 1) / MAZE_BLOCK_SIZE;
+        int blockColumns = (nodeColumns + MAZE_BLOCK_SIZE - 1) / MAZE_BLOCK_SIZE;
+        uint64_t blockCount = static_cast<uint64_t>(blockRows) * blockColumns;
+        parallelFor(blockRows, [&](int br) {
+            for (int bc = 0; bc < blockColumns; ++bc) {
+                Rng gen(Rng::mix(seed, 1 + static_cast<uint64_t>(br) * blockColumns + bc));
+                carveBlock(gen, br, bc);
+            }
+        });
+
+        Rng gen(Rng::mix(seed, 0));
+        joinBlocks(gen, blockRows, blockColumns);
+
+        // Wall removal probability with 8 bits of precision
+        unsigned braidRate = static_cast<unsigned>(std::lround(std::clamp(extraEdgeProb, 0.0, 1.0) * 256));
+        if (braidRate > 0) {
+            parallelFor(blockRows, [&](int br) {
+                Rng gen(Rng::mix(seed, 1 + blockCount + br));
+                braidRows(gen, br * MAZE_BLOCK_SIZE, std::min((br + 1) * MAZE_BLOCK_SIZE, nodeRows), braidRate);
+            });
+        }
+    }
+
+    // Copies in wall planes carved earlier by generateMaze(seed, extraEdgeProb)
+    // on a board of this size (a maze library), in the layout of getView()
+    void loadMaze(const uint64_t* eastWalls, const uint64_t* southWalls, uint64_t seed, double extraEdgeProb) {
+        ++topologyVersion;
+        mazeSeed = seed;
+        mazeBraid = extraEdgeProb;
+        mazeCarved = true;
+        moveTable.clear();
+        std::copy_n(eastWalls, eastWallBits.size(), eastWallBits.begin());
+        std::copy_n(southWalls, southWallBits.size(), southWallBits.begin());
+        closeBoundary();
+    }
+
+    static Direction opposite(Direction d) {
+        return static_cast<Direction>((static_cast<int>(d) + 2) % directionSize);
+    }
+
+    static void step(int& row, int& col, Direction d) {
+        switch (d) {
+            case Direction::UP: --row; break;
+            case Direction::RIGHT: ++col; break;
+            case Direction::DOWN: ++row; break;
+            case Direction::LEFT: --col; break;
+        }
+    }
+
+private:
+    // Iterative DFS over one block. A block is exactly one bit-plane word wide,
+    // so it is carved in local bit boards whose sentinel rows and columns are
+    // marked visited, and picking a direction needs no bounds checks. The
+    // direction back to each cell's parent replaces an explicit stack.
+    void carveBlock(Rng& gen, int blockRow, int blockColumn) {
+        struct DirectionTable {
+            uint8_t count[16];
+            uint8_t nth[16][4];
+            constexpr DirectionTable() : count(), nth() {
+                for (int mask = 0; mask < 16; ++mask) {
+                    for (int d = 0; d < directionSize; ++d) {
+                        if (mask & (1 << d)) nth[mask][count[mask]++] = static_cast<uint8_t>(d);
+                    }
+                }
+            }
+        };
+        static constexpr DirectionTable table;
+        static constexpr int rowStep[directionSize] = {-1, 0, 1, 0};
+        static constexpr int colStep[directionSize] = {0, 1, 0, -1};
+
+        int row0 = blockRow * MAZE_BLOCK_SIZE;
+        int height = std::min(MAZE_BLOCK_SIZE, nodeRows - row0);
+        int width = std::min(MAZE_BLOCK_SIZE, nodeColumns - blockColumn * MAZE_BLOCK_SIZE);
+        uint64_t padding = width == 64 ? 0 : ~0ULL << width;
+
+        uint64_t visited[MAZE_BLOCK_SIZE + 2]; // Row r of the block is visited[r + 1]
+        uint64_t east[MAZE_BLOCK_SIZE];
+        uint64_t south[MAZE_BLOCK_SIZE];
+        uint8_t parent[MAZE_BLOCK_SIZE * MAZE_BLOCK_SIZE];
+        visited[0] = ~0ULL;
+        for (int r = 0; r < height; ++r) {
+            visited[r + 1] = padding;
+            east[r] = ~0ULL;
+            south[r] = ~0ULL;
+        }
+        visited[height + 1] = ~0ULL;
+
+        int r = 0, c = 0;
+        visited[1] |= 1;
+        while (true) {
+            uint64_t here = visited[r + 1];
+            unsigned open = static_cast<unsigned>(~(visited[r] >> c) & 1)
+                          | static_cast<unsigned>(~(((here >> 1) | (1ULL << 63)) >> c) & 1) << 1
+                          | static_cast<unsigned>(~(visited[r + 2] >> c) & 1) << 2
+                          | static_cast<unsigned>(~(((here << 1) | 1) >> c) & 1) << 3;
+            if (open) {
+                int d = table.nth[open][gen.nextBelow(table.count[open])];
+                uint64_t* wallRow = (d & 1) ? &east[r] : &south[r - (d == 0)];
+                *wallRow &= ~(1ULL << (c - (d == 3)));
+                r += rowStep[d];
+                c += colStep[d];
+                visited[r + 1] |= 1ULL << c;
+                parent[r * MAZE_BLOCK_SIZE + c] = static_cast<uint8_t>((d + 2) % directionSize);
+            } else if (r == 0 && c == 0) {
+                break;
+            } else {
+                int d = parent[r * MAZE_BLOCK_SIZE + c];
+                r += rowStep[d];
+                c += colStep[d];
+            }
+        }
+
+        for (int i = 0; i < height; ++i) {
+            size_t word = static_cast<size_t>(row0 + i) * wordsPerRow + blockColumn;
+            eastWallBits[word] = east[i];
+            southWallBits[word] = south[i];
+        }
+    }
+
+    // Depth-first spanning tree over the block grid; each tree edge opens one
+    // randomly placed door in the border between the two blocks.
+    void joinBlocks(Rng& gen, int blockRows, int blockColumns) {
+        std::vector<uint8_t>& joined = blocksJoined;
+        std::vector<std::pair<int, int>>& path = blockPath;
+        joined.assign(static_cast<size_t>(blockRows) * blockColumns, false);
+        path.assign(1, {0, 0});
+        joined[0] = true;
+        while (!path.empty()) {
+            auto [br, bc] = path.back();
+            Direction candidates[directionSize];
+            uint32_t count = 0;
+            if (br > 0 && !joined[(br - 1) * blockColumns + bc]) candidates[count++] = Direction::UP;
+            if (bc < blockColumns - 1 && !joined[br * blockColumns + bc + 1]) candidates[count++] = Direction::RIGHT;
+            if (br < blockRows - 1 && !joined[(br + 1) * blockColumns + bc]) candidates[count++] = Direction::DOWN;
+            if (bc > 0 && !joined[br * blockColumns + bc - 1]) candidates[count++] = Direction::LEFT;
+            if (count == 0) {
+                path.pop_back();
+                continue;
+            }
+
+            Direction d = candidates[gen.nextBelow(count)];
+            int row0 = br * MAZE_BLOCK_SIZE;
+            int col0 = bc * MAZE_BLOCK_SIZE;
+            int height = std::min(MAZE_BLOCK_SIZE, nodeRows - row0);
+            int width = std::min(MAZE_BLOCK_SIZE, nodeColumns - col0);
+            switch (d) {
+                case Direction::UP:
+                    setWall(row0, col0 + gen.nextBelow(width), d, false);
+                    break;
+                case Direction::DOWN:
+                    setWall(row0 + height - 1, col0 + gen.nextBelow(width), d, false);
+                    break;
+                case Direction::LEFT:
+                    setWall(row0 + gen.nextBelow(height), col0, d, false);
+                    break;
+                case Direction::RIGHT:
+                    setWall(row0 + gen.nextBelow(height), col0 + width - 1, d, false);
+                    break;
+            }
+            step(br, bc, d);
+            joined[br * blockColumns + bc] = true;
+            path.push_back({br, bc});
+        }
+    }
+
+    // Word whose bits are each set with probability rate / 256
+    static uint64_t randomMask(Rng& gen, unsigned rate) {
+        if (rate >= 256) return ~0ULL;
+        uint64_t mask = 0;
+        for (int b = 0; b < 8; ++b) {
+            mask = ((rate >> b) & 1) ? (mask | gen.next()) : (mask & gen.next());
+        }
+        return mask;
+    }
+
+    // Clears each inner wall of rows [row0, row1) with probability rate / 256,
+    // 64 walls at a time. The board edge is never opened.
+    void braidRows(Rng& gen, int row0, int row1, unsigned rate) {
+        int lastBit = (nodeColumns - 1) % 64;
+        uint64_t eastKeep = ~0ULL << lastBit;
+        uint64_t southKeep = lastBit == 63 ? 0 : ~0ULL << (lastBit + 1);
+        for (int row = row0; row < row1; ++row) {
+            for (int w = 0; w < wordsPerRow; ++w) {
+                bool last = w == wordsPerRow - 1;
+                size_t word = static_cast<size_t>(row) * wordsPerRow + w;
+                eastWallBits[word] &= ~(randomMask(gen, rate) & ~(last ? eastKeep : 0));
+                if (row < nodeRows - 1) {
+                    southWallBits[word] &= ~(randomMask(gen, rate) & ~(last ? southKeep : 0));
+                }
+            }
+        }
+    }
+
+public:
+
+    // Method to move player and check if they reach the treasure. What happens
+    // is reported as GameEvents on getEvents() instead of being printed. The
+    // destination, portal included, comes from the move table.
+    void movePlayer(Player& player, char direction) {
+        const MoveTable& moves = getMoveTable();
+        int d = GameState::directionOf(direction);
+        int64_t from = cellOf(player.getCurrentPosition());
+        uint32_t entry;
+        if (d < 0) {
+            entry = MoveTable::stayEntry(getView(), from);
+            emit(GameEventType::INVALID_MOVE, player, direction);
+        } else {
+            size_t index = static_cast<size_t>(from) * directionSize + d;
+            entry = moves.open[index];
+            if (entry & MoveTable::MOVE_BLOCKED) {
+                if (moves.jump[index] & MoveTable::MOVE_BLOCKED) {
+                    emit(GameEventType::BOUNDARY_HIT, player, direction);
+                } else if (jumpWall(player)) {
+                    entry = moves.jump[index];
+                } else {
+                    emit(GameEventType::WALL_HIT, player, direction);
+                }
+            }
+        }
+
+        // Check if player has reached the treasure after the move
+        int64_t landing = moves.landing(from, d, entry);
+        player.setCurrentPosition({static_cast<int>(landing / nodeColumns), static_cast<int>(landing % nodeColumns)});
+        if (landing == cellOf(treasure.getPosition())) {
+            player.setHasWon(true);
+            emit(GameEventType::TREASURE_FOUND, player, direction);
+        }
+
+        // Check if player was on a portal and teleport them
+        int64_t cell = entry & MoveTable::MOVE_CELL;
+        if (entry & MoveTable::MOVE_TELEPORTED) {
+            player.setCurrentPosition({static_cast<int>(cell / nodeColumns), static_cast<int>(cell % nodeColumns)});
+            emit(GameEventType::TELEPORT, player, direction);
+        }
+
+        // Check if player is on a power and pick it up; a player holds one at a time
+        if ((features.flags[cell] & CELL_POWER) && player.getHeldPower() == PowerType::NONE) {
+            Power& pickup = powers[features.pickupSlots.find(cell)->second];
+            player.setHeldPower(pickup.getPowerType());
+            pickup.consume();
+            features.flags[cell] &= ~CELL_POWER;
+            emit(GameEventType::POWER_FOUND, player, direction, player.getHeldPower());
+        }
+    }
+
+    // Method to apply the effect of a power on the player. The effect is armed
+    // for the player's next move:
+    //   DOUBLE_PLAY    the move does not end the turn, so the player moves again
+    //   CONTROL_ENEMY  the move is made with the opponent's piece
+    //   JUMP_WALL      a move into an inner wall goes through it
+    void applyPowerEffect(Player& player, PowerType type) {
+        switch (type) {
+            case PowerType::DOUBLE_PLAY:
+            case PowerType::CONTROL_ENEMY:
+            case PowerType::JUMP_WALL:
+                player.setActivePower(type);
+                emit(GameEventType::POWER_ACTIVATED, player, 0, type);
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Spends the held power; false when the player has none
+    bool activatePower(Player& player) {
+        if (player.getHeldPower() == PowerType::NONE) return false;
+        applyPowerEffect(player, player.getHeldPower());
+        player.setHeldPower(PowerType::NONE);
+        return true;
+    }
+
+    // One action by the player whose turn it is: a WASD move or USE_POWER.
+    // Returns true when the same player acts again (after activating a power
+    // or the first move of a DOUBLE_PLAY), false when the turn passes.
+    bool takeTurn(Player& mover, Player& opponent, char action) {
+        if (action == USE_POWER) {
+            if (!activatePower(mover)) emit(GameEventType::INVALID_MOVE, mover, action);
+            return true;
+        }
+        Player& moved = mover.getActivePower() == PowerType::CONTROL_ENEMY ? opponent : mover;
+        if (&moved != &mover) mover.setActivePower(PowerType::NONE);
+        movePlayer(moved, action);
+        if (moved.getHasWon()) return false;
+        if (mover.getActivePower() == PowerType::DOUBLE_PLAY) {
+            mover.setActivePower(PowerType::NONE);
+            return true;
+        }
+        return false;
+    }
+
+    EventRing& getEvents() {
+        return events;
+    }
+
+    // Hands every pending event to the sink, oldest first
+    void drainEvents(EventSink& sink) {
+        GameEvent event;
+        while (events.pop(event)) sink.onEvent(event);
+    }
+
+};
+
+// Search limits for MctsPlayer. A search stops at whichever of budgetMs and
+// iterations (per thread) comes first; 0 leaves that limit out. With both
+// left out the player falls back to the default time budget.
+struct MctsOptions {
+    int budgetMs = 200;
+    long long iterations = 0;
+    int threads = 0;              // 0 = one per hardware thread
+    double exploration = 0.7;
+    int rolloutDepth = 40;        // Plies before a rollout is scored by distances
+    double greedyRollout = 0.75;  // Chance a rollout move follows the distance field
+    size_t maxNodes = 1 << 20;    // Per thread; a full tree keeps running rollouts from its leaves
+    uint64_t seed = 1;
+};
+
+struct MctsStats {
+    long long rollouts = 0;
+    double seconds = 0;
+    int threads = 0;
+
+    double rolloutsPerSecondPerCore() const {
+        return seconds > 0 && threads > 0 ? rollouts / seconds / threads : 0;
+    }
+};
+
+// Computer player: Monte Carlo tree search with root parallelism. Every
+// thread grows its own tree from the current position and the root visit
+// counts are summed at the end. Tree nodes hold GameStates, so the search
+// plays by the same rules as nodeMatrix::takeTurn: portals, picking up powers
+// and what each power does. Rollouts mostly walk the distance field towards
+// the treasure (away from it when moving the opponent's piece) and are scored
+// by distance to the treasure at the cutoff.
+class MctsPlayer {
+private:
+    static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+    struct Node {
+        GameState state;
+        uint32_t parent;
+        uint32_t firstChild;
+        uint32_t visits;
+        float value;          // Results summed for the player who chose action
+        uint8_t childCount;
+        char action;
+        int8_t mover;
+    };
+
+    struct Tree {
+        std::vector<Node> nodes;
+        Rng rng;
+        long long rollouts = 0;
+    };
+
+    MctsOptions options;
+    GameBoard board;          // Copy of the header only; still points at the matrix's walls and MoveTable
+    int64_t cells = 0;
+    std::vector<int> toTreasure;
+    GameState root = {};
+    std::vector<Tree> trees;
+    MctsStats stats;
+    uint64_t searchCount = 0;
+
+    int distanceOf(int64_t cell) const {
+        int distance = toTreasure[cell];
+        return distance < 0 ? static_cast<int>(cells) : distance;
+    }
+
+    // Score of s for player 1: about the chance to win. A lost game still
+    // scores a little more the closer the loser got, and a win a little more
+    // the sooner it came, so neither side plays aimlessly in a decided race.
+    float evaluate(const GameState& s) const {
+        if (s.winner >= 0) {
+            float margin = 0.2f / (1.0f + distanceOf(s.cell[1 - s.winner])) + 0.001f * s.ply;
+            return s.winner == 0 ? 1.0f - margin : margin;
+        }
+        float lead = static_cast<float>(distanceOf(s.cell[1]) - distanceOf(s.cell[0])) + (s.toMove == 0 ? 0.5f : -0.5f);
+        return 1.0f / (1.0f + std::exp(-0.35f * lead));
+    }
+
+    float rollout(GameState s, Rng& rng) const {
+        char actions[GAME_ACTION_COUNT];
+        for (int depth = 0; depth < options.rolloutDepth && s.winner < 0; ++depth) {
+            int count = s.legalActions(actions);
+            if (count == 0) break;
+            char choice = actions[rng.nextBelow(count)];
+            if (s.heldPower(s.toMove) != PowerType::NONE && rng.chance(0.25)) {
+                choice = USE_POWER;
+            } else if (rng.chance(options.greedyRollout)) {
+                int piece = s.controlledPiece();
+                int sign = piece == s.toMove ? 1 : -1; // Lead an opponent's piece away
+                int best = INT32_MAX;
+                for (int i = 0; i < count; ++i) {
+                    int d = GameState::directionOf(actions[i]);
+                    if (d < 0) continue;
+                    int score = sign * distanceOf(s.moveEntry(piece, d) & MoveTable::MOVE_CELL);
+                    if (score < best) {
+                        best = score;
+                        choice = actions[i];
+                    }
+                }
+            }
+            s.apply(choice);
+        }
+        return evaluate(s);
+    }
+
+    void expand(Tree& tree, uint32_t index) {
+        char actions[GAME_ACTION_COUNT];
+        GameState state = tree.nodes[index].state;
+        int count = state.legalActions(actions);
+        uint32_t first = static_cast<uint32_t>(tree.nodes.size());
+        for (int i = 0; i < count; ++i) {
+            Node child = {state, index, NO_NODE, 0, 0.0f, 0, actions[i], static_cast<int8_t>(state.toMove)};
+            child.state.apply(actions[i]);
+            tree.nodes.push_back(child);
+        }
+        tree.nodes[index].firstChild = first;
+        tree.nodes[index].childCount = static_cast<uint8_t>(count);
+    }
+
+    uint32_t selectChild(Tree& tree, const Node& node) const {
+        double logVisits = std::log(static_cast<double>(std::max(1u, node.visits)));
+        uint32_t best = node.firstChild;
+        double bestScore = -1;
+        for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; ++c) {
+            const Node& child = tree.nodes[c];
+            // Unvisited children first, in random order
+            double score = child.visits == 0 ? 2.0 + tree.rng.nextDouble()
+                                             : child.value / child.visits + options.exploration * std::sqrt(logVisits / child.visits);
+            if (score > bestScore) {
+                bestScore = score;
+                best = c;
+            }
+        }
+        return best;
+    }
+
+    void iterate(Tree& tree) {
+        uint32_t index = 0;
+        while (tree.nodes[index].childCount > 0) index = selectChild(tree, tree.nodes[index]);
+        if (tree.nodes[index].state.winner < 0 && (tree.nodes[index].visits > 0 || index == 0) &&
+            tree.nodes.size() + GAME_ACTION_COUNT <= options.maxNodes) {
+            expand(tree, index);
+            if (tree.nodes[index].childCount > 0) index = selectChild(tree, tree.nodes[index]);
+        }
+        float result = rollout(tree.nodes[index].state, tree.rng);
+        ++tree.rollouts;
+        for (uint32_t n = index; n != NO_NODE; n = tree.nodes[n].parent) {
+            Node& node = tree.nodes[n];
+            ++node.visits;
+            node.value += node.mover == 0 ? result : 1.0f - result;
+        }
+    }
+
+    void grow(Tree& tree, std::chrono::steady_clock::time_point deadline) {
+        tree.nodes.clear();
+        tree.nodes.push_back({root, NO_NODE, NO_NODE, 0, 0.0f, 0, 0, static_cast<int8_t>(1 - root.toMove)});
+        tree.rollouts = 0;
+        for (long long i = 0; options.iterations <= 0 || i < options.iterations; ++i) {
+            // The clock is read every 64 iterations
+            if (options.budgetMs > 0 && (i & 63) == 0 && std::chrono::steady_clock::now() >= deadline) break;
+            iterate(tree);
+        }
+    }
+
+public:
+    explicit MctsPlayer(const MctsOptions& options = MctsOptions()) : options(options) {
+        // A search with no limit at all would never return
+        if (this->options.budgetMs <= 0 && this->options.iterations <= 0) this->options.budgetMs = MctsOptions().budgetMs;
+    }
+
+    // Takes a snapshot of the match with me to act. search() may then run
+    // on another thread, but it reads the matrix's wall planes and MoveTable,
+    // so the maze must not be changed or replaced until it returns
+    void setPosition(nodeMatrix& matrix, const Player& me, const Player& opponent) {
+        const Player& player1 = me.getTurn() == PlayerTurn::PLAYER1 ? me : opponent;
+        const Player& player2 = me.getTurn() == PlayerTurn::PLAYER1 ? opponent : me;
+        root = matrix.snapshot(player1, player2, me.getTurn());
+        board = *root.board;
+        root.board = &board;
+        cells = static_cast<int64_t>(board.maze.rows) * board.maze.columns;
+        if (board.treasureCell >= 0) {
+            const std::vector<int>& field = matrix.getDistanceField(DistanceSource::TREASURE).getDistances();
+            toTreasure.assign(field.begin(), field.end());
+        } else {
+            toTreasure.assign(cells, 0);
+        }
+    }
+
+    // Searches the position from setPosition and returns the action to take
+    char search() {
+        int threadCount = options.threads > 0 ? options.threads : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        if (trees.size() != static_cast<size_t>(threadCount)) trees.resize(threadCount);
+        ++searchCount;
+        for (int t = 0; t < threadCount; ++t) trees[t].rng.reseed(Rng::mix(options.seed, searchCount * 1024 + t));
+
+        auto start = std::chrono::steady_clock::now();
+        auto deadline = start + std::chrono::milliseconds(options.budgetMs);
+        std::vector<std::thread> workers;
+        for (int t = 1; t < threadCount; ++t) {
+            workers.emplace_back([this, t, deadline]() { grow(trees[t], deadline); });
+        }
+        grow(trees[0], deadline);
+        for (auto& worker : workers) worker.join();
+
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        stats.threads = threadCount;
+        stats.rollouts = 0;
+        double visits[GAME_ACTION_COUNT] = {};
+        for (const Tree& tree : trees) {
+            stats.rollouts += tree.rollouts;
+            const Node& top = tree.nodes[0];
+            for (uint32_t c = top.firstChild; c < top.firstChild + top.childCount; ++c) {
+                visits[std::find(gameActions, gameActions + GAME_ACTION_COUNT, tree.nodes[c].action) - gameActions] += tree.nodes[c].visits;
+            }
+        }
+        int best = -1;
+        for (int a = 0; a < GAME_ACTION_COUNT; ++a) {
+            if (visits[a] > 0 && (best < 0 || visits[a] > visits[best])) best = a;
+        }
+        return best < 0 ? 'x' : gameActions[best];
+    }
+
+    char chooseMove(nodeMatrix& matrix, const Player& me, const Player& opponent) {
+        setPosition(matrix, me, opponent);
+        return search();
+    }
+
+    const MctsStats& getStats() const {
+        return stats;
+    }
+
+    const MctsOptions& getOptions() const {
+        return options;
+    }
+
+    // Restarts the search seeds from seed, as if the player were new. The
+    // moves it picks then depend only on seed and the positions it is given,
+    // not on how many searches it ran before.
+    void reseed(uint64_t seed) {
+        options.seed = seed;
+        searchCount = 0;
+    }
+};
+
+// Match recordings. A replay holds what rebuilds the board (seeds, size,
+// braid, where the treasure, portals and pickups were put) and every action as a
+// 3-bit code, 21 to a 64-bit word, so even a long match takes a few KB.
+// Events are not stored: playing the actions back through takeTurn emits
+// them again. Every keyframeInterval actions a keyframe stores the whole
+// GameState, so playback can jump to any turn by replaying at most one
+// interval, and its hash shows whether playback still follows the recording.
+const uint32_t REPLAY_VERSION = 2;
+const uint32_t REPLAY_KEYFRAME_INTERVAL = 256;
+const int REPLAY_ACTION_BITS = 3;
+const int REPLAY_ACTIONS_PER_WORD = 64 / REPLAY_ACTION_BITS;
+const char REPLAY_INVALID_ACTION = 'x'; // Stands for any input that is not an action
+
+// File layout: this header, portalCount then pickupCount ReplayFeatures,
+// keyframeCount ReplayKeyframes, then the action words, all in native layout
+// like the asset bundle
+struct ReplayHeader {
+    char magic[8];            // "MZREPLAY"
+    uint32_t version;
+    uint32_t keyframeInterval;
+    uint64_t seed;            // nodeMatrix seed
+    uint64_t mazeSeed;
+    double mazeBraid;
+    int32_t rows;
+    int32_t columns;
+    int64_t treasureCell;     // -1 without a treasure
+    uint32_t portalCount;
+    uint32_t pickupCount;
+    uint32_t mazeCarved;      // 0 for a board that was never carved (tests)
+    uint32_t padding;
+    uint64_t mazeChecksum;
+    uint64_t actionCount;
+    uint64_t keyframeCount;   // Always actionCount / keyframeInterval + 1
+};
+
+// A portal (cell and the other end) or a pickup (cell and PowerType), in slot order
+struct ReplayFeature {
+    int64_t cell;
+    int64_t value;
+};
+
+// A GameState without its board pointer
+struct ReplayKeyframe {
+    uint64_t hash;
+    uint64_t pickupsTaken;
+    int32_t cell[2];
+    uint8_t held[2];
+    uint8_t active[2];
+    uint8_t toMove;
+    int8_t winner;
+    uint8_t padding[2];
+};
+
+class Replay {
+private:
+    ReplayHeader header = {};
+    std::vector<ReplayFeature> features;  // Portals, then pickups
+    std::vector<ReplayKeyframe> keyframes;
+    std::vector<uint64_t> actionWords;
+
+    static bool validHeader(const ReplayHeader& h) {
+        return std::equal(h.magic, h.magic + 8, "MZREPLAY") && h.version == REPLAY_VERSION && h.keyframeInterval > 0 &&
+               h.rows > 0 && h.columns > 0 && h.keyframeCount == h.actionCount / h.keyframeInterval + 1 &&
+               validCell(h, h.treasureCell);
+    }
+
+    // -1 (off the board) or a cell of the recorded board
+    static bool validCell(const ReplayHeader& h, int64_t cell) {
+        return cell >= -1 && cell < static_cast<int64_t>(h.rows) * h.columns;
+    }
+
+    // A keyframe is played forward through GameState::apply, which indexes
+    // the board with its cells and the Zobrist tables with its powers
+    static bool validKeyframe(const ReplayHeader& h, const ReplayKeyframe& key) {
+        const uint8_t maxPower = static_cast<uint8_t>(PowerType::JUMP_WALL);
+        return validCell(h, key.cell[0]) && validCell(h, key.cell[1]) && key.held[0] <= maxPower && key.held[1] <= maxPower &&
+               key.active[0] <= maxPower && key.active[1] <= maxPower && key.toMove <= static_cast<uint8_t>(PlayerTurn::PLAYER2) &&
+               key.winner >= -1 && key.winner <= static_cast<int8_t>(PlayerTurn::PLAYER2);
+    }
+
+public:
+    // Code of an action in the log: the Direction, then USE_POWER, then anything else
+    static int encode(char action) {
+        int direction = GameState::directionOf(action);
+        if (direction >= 0) return direction;
+        return action == USE_POWER ? directionSize : directionSize + 1;
+    }
+
+    static char decode(int code) {
+        return code < GAME_ACTION_COUNT ? gameActions[code] : REPLAY_INVALID_ACTION;
+    }
+
+    // Drops any recording and describes the board of matrix as it is now
+    void reset(nodeMatrix& matrix, uint32_t keyframeInterval = REPLAY_KEYFRAME_INTERVAL) {
+        const GameBoard& board = matrix.getGameBoard();
+        header = {};
+        std::copy_n("MZREPLAY", 8, header.magic);
+        header.version = REPLAY_VERSION;
+        header.keyframeInterval = std::max(1u, keyframeInterval);
+        header.seed = matrix.getSeed();
+        header.mazeSeed = matrix.getMazeSeed();
+        header.mazeBraid = matrix.getMazeBraid();
+        header.rows = matrix.getRows();
+        header.columns = matrix.getColumns();
+        header.treasureCell = board.treasureCell;
+        header.portalCount = static_cast<uint32_t>(matrix.getPortals().size());
+        header.pickupCount = static_cast<uint32_t>(matrix.getPowers().size());
+        header.mazeCarved = matrix.isMazeCarved();
+        header.mazeChecksum = matrix.getMazeChecksum();
+        features.clear();
+        for (const Portal& portal : matrix.getPortals()) {
+            features.push_back({matrix.cellOf(portal.getPortalAPosition()), matrix.cellOf(portal.getPortalBPosition())});
+        }
+        for (const Power& pickup : matrix.getPowers()) {
+            features.push_back({matrix.cellOf(pickup.getPosition()), static_cast<int64_t>(pickup.getPowerType())});
+        }
+        keyframes.clear();
+        actionWords.clear();
+    }
+
+    // Appends one action; state is the position before it, and becomes a
+    // keyframe when the action starts a new interval
+    void append(char action, const GameState& state) {
+        uint64_t index = header.actionCount;
+        if (index % header.keyframeInterval == 0) {
+            keyframes.push_back({state.hash, state.pickupsTaken, {state.cell[0], state.cell[1]}, {state.held[0], state.held[1]},
+                                 {state.active[0], state.active[1]}, state.toMove, state.winner, {0, 0}});
+        }
+        if (index % REPLAY_ACTIONS_PER_WORD == 0) actionWords.push_back(0);
+        actionWords.back() |= static_cast<uint64_t>(encode(action)) << (index % REPLAY_ACTIONS_PER_WORD * REPLAY_ACTION_BITS);
+        ++header.actionCount;
+    }
+
+    // Closes the log with a keyframe of the final position when it is due
+    void finish(const GameState& state) {
+        if (header.actionCount / header.keyframeInterval + 1 > keyframes.size()) {
+            keyframes.push_back({state.hash, state.pickupsTaken, {state.cell[0], state.cell[1]}, {state.held[0], state.held[1]},
+                                 {state.active[0], state.active[1]}, state.toMove, state.winner, {0, 0}});
+        }
+        header.keyframeCount = keyframes.size();
+    }
+
+    char actionAt(uint64_t index) const {
+        uint64_t word = actionWords[index / REPLAY_ACTIONS_PER_WORD];
+        return decode(static_cast<int>(word >> (index % REPLAY_ACTIONS_PER_WORD * REPLAY_ACTION_BITS) & 7));
+    }
+
+    uint64_t getActionCount() const {
+        return header.actionCount;
+    }
+
+    const ReplayHeader& getHeader() const {
+        return header;
+    }
+
+    // Position before action index: the keyframe at or before it, played forward
+    GameState stateBefore(const GameBoard& board, uint64_t index) const {
+        index = std::min(index, header.actionCount);
+        uint64_t k = std::min<uint64_t>(index / header.keyframeInterval, keyframes.size() - 1);
+        const ReplayKeyframe& key = keyframes[k];
+        GameState state = {&board, key.hash, key.pickupsTaken, {key.cell[0], key.cell[1]}, {key.held[0], key.held[1]},
+                           {key.active[0], key.active[1]}, key.toMove, key.winner, 0};
+        for (uint64_t i = k * header.keyframeInterval; i < index; ++i) state.apply(actionAt(i));
+        return state;
+    }
+
+    uint64_t keyframeHash(uint64_t k) const {
+        return keyframes[k].hash;
+    }
+
+    // Rebuilds the recorded board on a fresh matrix made with
+    // nodeMatrix(header.rows, header.columns, header.seed). Returns false when
+    // the board came out different, e.g. after a maze generator change, or
+    // without touching matrix when a feature is off the board or a pickup
+    // holds a power type that does not exist.
+    bool setUpBoard(nodeMatrix& matrix) const {
+        if (matrix.getRows() != header.rows || matrix.getColumns() != header.columns || matrix.getSeed() != header.seed) {
+            return false;
+        }
+        auto position = [&](int64_t cell) {
+            return cell < 0 ? std::make_pair(-1, -1) : std::make_pair(static_cast<int>(cell / header.columns), static_cast<int>(cell % header.columns));
+        };
+        // Cells and power types come from the file; check them all before
+        // the matrix is touched
+        std::vector<Portal> portals;
+        std::vector<Power> pickups;
+        for (uint32_t i = 0; i < header.portalCount; ++i) {
+            if (!validCell(header, features[i].cell) || !validCell(header, features[i].value)) return false;
+            portals.emplace_back(position(features[i].cell), position(features[i].value));
+        }
+        for (uint32_t i = header.portalCount; i < features.size(); ++i) {
+            int64_t type = features[i].value;
+            if (!validCell(header, features[i].cell) ||
+                type < static_cast<int64_t>(PowerType::DOUBLE_PLAY) || type > static_cast<int64_t>(PowerType::JUMP_WALL)) {
+                return false;
+            }
+            pickups.emplace_back(position(features[i].cell), static_cast<PowerType>(type));
+        }
+        if (header.mazeCarved) matrix.generateMaze(header.mazeSeed, header.mazeBraid);
+        matrix.setFeatures(portals, pickups);
+        matrix.setTreasure(position(header.treasureCell).first, position(header.treasureCell).second);
+        return matrix.getMazeChecksum() == header.mazeChecksum;
+    }
+
+    bool save(const std::string& path) const {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) return false;
+        bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                       std::fwrite(features.data(), sizeof(ReplayFeature), features.size(), file) == features.size() &&
+                       std::fwrite(keyframes.data(), sizeof(ReplayKeyframe), keyframes.size(), file) == keyframes.size() &&
+                       std::fwrite(actionWords.data(), sizeof(uint64_t), actionWords.size(), file) == actionWords.size();
+        return std::fclose(file) == 0 && written;
+    }
+
+    bool load(const std::string& path) {
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) return false;
+        ReplayHeader loaded;
+        bool read = std::fread(&loaded, sizeof(loaded), 1, file) == 1 && validHeader(loaded);
+        // Check the sizes against the file before allocating anything
+        long end = read && std::fseek(file, 0, SEEK_END) == 0 ? std::ftell(file) : -1;
+        uint64_t words = (loaded.actionCount + REPLAY_ACTIONS_PER_WORD - 1) / REPLAY_ACTIONS_PER_WORD;
+        read = read && end >= 0 &&
+               static_cast<uint64_t>(end) == sizeof(loaded) + (static_cast<uint64_t>(loaded.portalCount) + loaded.pickupCount) * sizeof(ReplayFeature) +
+                                                loaded.keyframeCount * sizeof(ReplayKeyframe) + words * sizeof(uint64_t) &&
+               std::fseek(file, sizeof(loaded), SEEK_SET) == 0;
+        // Read into new buffers, so a refused file leaves this replay as it was
+        std::vector<ReplayFeature> loadedFeatures;
+        std::vector<ReplayKeyframe> loadedKeyframes;
+        std::vector<uint64_t> loadedWords;
+        if (read) {
+            loadedFeatures.resize(static_cast<size_t>(loaded.portalCount) + loaded.pickupCount);
+            loadedKeyframes.resize(loaded.keyframeCount);
+            loadedWords.resize(words);
+            read = std::fread(loadedFeatures.data(), sizeof(ReplayFeature), loadedFeatures.size(), file) == loadedFeatures.size() &&
+                   std::fread(loadedKeyframes.data(), sizeof(ReplayKeyframe), loadedKeyframes.size(), file) == loadedKeyframes.size() &&
+                   std::fread(loadedWords.data(), sizeof(uint64_t), loadedWords.size(), file) == loadedWords.size();
+        }
+        std::fclose(file);
+        for (size_t k = 0; read && k < loadedKeyframes.size(); ++k) read = validKeyframe(loaded, loadedKeyframes[k]);
+        if (read) {
+            header = loaded;
+            features.swap(loadedFeatures);
+            keyframes.swap(loadedKeyframes);
+            actionWords.swap(loadedWords);
+        }
+        return read;
+    }
+};
+
+// Records a match as it is played. It follows the match on its own
+// GameState, so the game loop only hands over each action.
+class ReplayRecorder {
+private:
+    Replay replay;
+    GameBoard board;  // Own copy, points into the matrix's maze
+    GameState state = {};
+
+public:
+    // Starts recording the match as it stands, with toMove acting first
+    void start(nodeMatrix& matrix, const Player& player1, const Player& player2, PlayerTurn toMove,
+               uint32_t keyframeInterval = REPLAY_KEYFRAME_INTERVAL) {
+        replay.reset(matrix, keyframeInterval);
+        board = matrix.getGameBoard();
+        state = matrix.snapshot(player1, player2, toMove);
+        state.board = &board;
+        state.ply = 0;
+    }
+
+    // Call with every action passed to nodeMatrix::takeTurn, in order
+    void record(char action) {
+        replay.append(action, state);
+        state.apply(action);
+    }
+
+    // The recording so far, with the closing keyframe in place
+    const Replay& getReplay() {
+        replay.finish(state);
+        return replay;
+    }
+
+    bool save(const std::string& path) {
+        return getReplay().save(path);
+    }
+};
+
+// Plays a Replay back on a matrix rebuilt with Replay::setUpBoard. step()
+// goes through takeTurn, so events come out as they did in the match; seek()
+// jumps anywhere from the nearest keyframe without emitting events.
+class ReplayPlayer {
+private:
+    const Replay& replay;
+    nodeMatrix& matrix;
+    Player* players[2];
+    GameState state = {};
+    uint64_t cursor = 0;
+    bool diverged = false;
+
+public:
+    ReplayPlayer(const Replay& replay, nodeMatrix& matrix, Player& player1, Player& player2)
+        : replay(replay), matrix(matrix), players{&player1, &player2} {
+        seek(0);
+    }
+
+    // Plays the next recorded action. Returns false at the end of the recording.
+    bool step() {
+        if (atEnd()) return false;
+        char action = replay.actionAt(cursor++);
+        int me = state.toMove;
+        matrix.takeTurn(*players[me], *players[1 - me], action);
+        state.apply(action);
+        // The players are checked against each keyframe passed
+        uint64_t interval = replay.getHeader().keyframeInterval;
+        if (cursor % interval == 0 && cursor / interval < replay.getHeader().keyframeCount) {
+            GameState played = matrix.snapshot(*players[0], *players[1], static_cast<PlayerTurn>(state.toMove));
+            if (played.hash != replay.keyframeHash(cursor / interval)) diverged = true;
+        }
+        return true;
+    }
+
+    // Moves to just before action index (clamped to the end)
+    void seek(uint64_t index) {
+        state = replay.stateBefore(matrix.getGameBoard(), index);
+        cursor = std::min(index, replay.getActionCount());
+        matrix.restore(state, *players[0], *players[1]);
+    }
+
+    uint64_t getCursor() const {
+        return cursor;
+    }
+
+    bool atEnd() const {
+        return cursor >= replay.getActionCount();
+    }
+
+    PlayerTurn getToMove() const {
+        return static_cast<PlayerTurn>(state.toMove);
+    }
+
+    const GameState& getState() const {
+        return state;
+    }
+
+    // True once the players stopped matching the recorded keyframes
+    bool hasDiverged() const {
+        return diverged;
+    }
+};
+
+// Matches hosted for network clients. Clients and the match server exchange
+// fixed-size messages in native layout (both run on one box); the first byte
+// is the NetMessage and fixes the size, so a byte stream splits into messages
+// without length prefixes. Actions are the same characters takeTurn takes.
+//   CREATE -> CREATED  new board from a seed, built like the game builds it;
+//                      with NET_SEAT_BOTH the client plays both sides
+//   JOIN   -> JOINED   takes player 2's seat; the creator is told as well
+//   ACTION -> MOVED    one action by the seat to move, sent to both seats
+//   LEAVE  -> LEFT     sent to the other seat; the match is gone once both left
+// Anything refused gets an ERROR naming the match and the NetError.
+enum class NetMessage : uint8_t { CREATE = 1, JOIN, ACTION, LEAVE, CREATED, JOINED, MOVED, LEFT, ERROR };
+enum class NetError : uint8_t { NONE, NO_MATCH, SEAT_TAKEN, NOT_YOUR_TURN, GAME_OVER, BAD_BOARD };
+const uint8_t NET_SEAT_BOTH = 1;          // NetCreate flag
+const int64_t NET_MAX_CELLS = 1 << 20;    // Largest board a client may ask for
+const int NET_MATCH_SHARDS = 64;          // Locks the match table is split over
+const size_t NET_SPARE_MATCHES = 4096;    // Ended matches kept for reuse
+const size_t NET_PROTOCOL_ERROR = SIZE_MAX;
+
+struct NetCreate {
+    uint8_t type;
+    uint8_t flags;
+    uint16_t rows;
+    uint16_t columns;
+    uint16_t padding;
+    uint32_t tag;             // Echoed in CREATED, so a client can pipeline creates
+    uint32_t padding2;
+    uint64_t seed;
+};
+
+// CREATED and JOINED; the board is nodeMatrix(rows, columns, seed) after
+// generateMaze(seed) and placeTreasure(true), checked by mazeChecksum
+struct NetMatchInfo {
+    uint8_t type;
+    uint8_t seat;             // PlayerTurn the receiver plays (player 2's for JOINED)
+    uint16_t rows;
+    uint16_t columns;
+    uint16_t padding;
+    uint32_t match;
+    uint32_t tag;
+    uint64_t seed;
+    uint64_t mazeChecksum;
+};
+
+// JOIN, ACTION, LEAVE, LEFT and ERROR
+struct NetMatchRef {
+    uint8_t type;
+    uint8_t code;             // NetError for ERROR, the seat that left for LEFT
+    char action;              // ACTION only
+    uint8_t padding;
+    uint32_t match;
+};
+
+// The position after an action, as GameState keeps it
+struct NetMoved {
+    uint8_t type;
+    char action;
+    uint8_t toMove;
+    int8_t winner;            // PlayerTurn, -1 while the match goes on
+    uint32_t match;
+    uint32_t ply;             // Actions taken in the match so far
+    int32_t cell[2];          // Row-major, indexed by PlayerTurn
+    uint8_t held[2];
+    uint8_t active[2];
+};
+
+// Size of a message from its first byte, 0 for an unknown type
+inline size_t netMessageSize(uint8_t type) {
+    switch (static_cast<NetMessage>(type)) {
+        case NetMessage::CREATE: return sizeof(NetCreate);
+        case NetMessage::CREATED:
+        case NetMessage::JOINED: return sizeof(NetMatchInfo);
+        case NetMessage::MOVED: return sizeof(NetMoved);
+        case NetMessage::JOIN:
+        case NetMessage::ACTION:
+        case NetMessage::LEAVE:
+        case NetMessage::LEFT:
+        case NetMessage::ERROR: return sizeof(NetMatchRef);
+    }
+    return 0;
+}
+
+// One connection as MatchHost sees it. send can be called from any thread
+// that holds a match lock, so the messages of one match stay in order.
+// matches is only used by the thread that feeds the client's input.
+class MatchClient {
+public:
+    virtual ~MatchClient() = default;
+    virtual void send(const void* message, size_t size) = 0;
+
+    // Seats held, for disconnect. Set nodes come back from a pool, so joining
+    // and leaving matches does not allocate once the set has reached its size.
+    std::pmr::unsynchronized_pool_resource matchNodes;
+    std::pmr::unordered_set<uint32_t> matches{&matchNodes};
+};
+
+// A board, its two players and who sits in each seat
+struct HostedMatch {
+    std::mutex lock;
+    uint32_t id;
+    nodeMatrix matrix;
+    Player players[2];
+    std::shared_ptr<MatchClient> seats[2];
+    uint8_t toMove = 0;
+    uint32_t ply = 0;
+
+    HostedMatch(uint32_t id, int rows, int columns, uint64_t seed)
+        : id(id), matrix(rows, columns, seed),
+          players{Player("Player 1", matrix.getPlayer1Start(), PlayerTurn::PLAYER1),
+                  Player("Player 2", matrix.getPlayer2Start(), PlayerTurn::PLAYER2)} {
+        matrix.generateMaze(seed);
+        if (!matrix.placeTreasure(true)) matrix.placeTreasure(false);
+    }
+
+    // Starts a new match in this one's buffers; the caller holds lock
+    void reset(uint32_t newId, int rows, int columns, uint64_t seed) {
+        id = newId;
+        matrix.reset(rows, columns, seed);
+        players[0] = Player("Player 1", matrix.getPlayer1Start(), PlayerTurn::PLAYER1);
+        players[1] = Player("Player 2", matrix.getPlayer2Start(), PlayerTurn::PLAYER2);
+        seats[0] = seats[1] = nullptr;
+        toMove = 0;
+        ply = 0;
+        matrix.generateMaze(seed);
+        if (!matrix.placeTreasure(true)) matrix.placeTreasure(false);
+    }
+
+    int winner() const {
+        return players[0].getHasWon() ? 0 : players[1].getHasWon() ? 1 : -1;
+    }
+};
+
+// The authoritative side of the match server, without the sockets: feeds
+// client bytes through the rules and sends the results back. Matches live in
+// a table split over NET_MATCH_SHARDS locks and each has its own lock, so
+// worker threads only contend when they touch the same match. Ended matches
+// are kept and reset for the next CREATE, and table nodes come from per-shard
+// pools, so under steady churn creating a match does not touch the heap.
+class MatchHost {
+private:
+    struct Shard {
+        std::mutex lock;
+        std::pmr::unsynchronized_pool_resource nodes;
+        std::pmr::unordered_map<uint32_t, std::shared_ptr<HostedMatch>> matches{&nodes};
+    };
+
+    Shard shards[NET_MATCH_SHARDS];
+    std::mutex spareLock;
+    std::vector<std::shared_ptr<HostedMatch>> spareMatches;
+    std::atomic<uint32_t> nextId{1};
+    std::atomic<int64_t> liveMatches{0};
+    std::atomic<uint64_t> actionCount{0};
+
+    Shard& shardOf(uint32_t id) {
+        return shards[id % NET_MATCH_SHARDS];
+    }
+
+    std::shared_ptr<HostedMatch> find(uint32_t id) {
+        Shard& shard = shardOf(id);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto it = shard.matches.find(id);
+        return it == shard.matches.end() ? nullptr : it->second;
+    }
+
+    static void sendRef(MatchClient& client, NetMessage type, uint8_t code, uint32_t match) {
+        NetMatchRef reply = {static_cast<uint8_t>(type), code, 0, 0, match};
+        client.send(&reply, sizeof(reply));
+    }
+
+    static void sendError(MatchClient& client, NetError error, uint32_t match) {
+        sendRef(client, NetMessage::ERROR, static_cast<uint8_t>(error), match);
+    }
+
+    static NetMatchInfo matchInfo(NetMessage type, HostedMatch& match, uint8_t seat, uint32_t tag, uint64_t seed) {
+        return {static_cast<uint8_t>(type), seat, static_cast<uint16_t>(match.matrix.getRows()),
+                static_cast<uint16_t>(match.matrix.getColumns()), 0, match.id, tag, seed, match.matrix.getMazeChecksum()};
+    }
+
+    void create(const std::shared_ptr<MatchClient>& client, const NetCreate& request) {
+        if (request.rows < 2 || request.columns < 2 || static_cast<int64_t>(request.rows) * request.columns > NET_MAX_CELLS) {
+            sendError(*client, NetError::BAD_BOARD, 0);
+            return;
+        }
+        uint32_t id = nextId++;
+        std::shared_ptr<HostedMatch> match;
+        {
+            std::lock_guard<std::mutex> guard(spareLock);
+            if (!spareMatches.empty()) {
+                match = std::move(spareMatches.back());
+                spareMatches.pop_back();
+            }
+        }
+        if (match) {
+            std::lock_guard<std::mutex> guard(match->lock);
+            match->reset(id, request.rows, request.columns, request.seed);
+        } else {
+            match = std::make_shared<HostedMatch>(id, request.rows, request.columns, request.seed);
+        }
+        match->seats[0] = client;
+        if (request.flags & NET_SEAT_BOTH) match->seats[1] = client;
+        NetMatchInfo reply = matchInfo(NetMessage::CREATED, *match, 0, request.tag, request.seed);
+        {
+            Shard& shard = shardOf(id);
+            std::lock_guard<std::mutex> guard(shard.lock);
+            shard.matches.emplace(id, match);
+        }
+        ++liveMatches;
+        client->matches.insert(id);
+        client->send(&reply, sizeof(reply));
+    }
+
+    void join(const std::shared_ptr<MatchClient>& client, uint32_t id) {
+        std::shared_ptr<HostedMatch> match = find(id);
+        if (!match) {
+            sendError(*client, NetError::NO_MATCH, id);
+            return;
+        }
+        std::lock_guard<std::mutex> guard(match->lock);
+        if (match->id != id) {
+            sendError(*client, NetError::NO_MATCH, id); // Ended and reused meanwhile
+            return;
+        }
+        if (match->seats[1]) {
+            sendError(*client, NetError::SEAT_TAKEN, id);
+            return;
+        }
+        match->seats[1] = client;
+        client->matches.insert(id);
+        NetMatchInfo reply = matchInfo(NetMessage::JOINED, *match, 1, 0, match->matrix.getSeed());
+        client->send(&reply, sizeof(reply));
+        if (match->seats[0] && match->seats[0] != client) match->seats[0]->send(&reply, sizeof(reply));
+    }
+
+    void act(const std::shared_ptr<MatchClient>& client, uint32_t id, char action) {
+        std::shared_ptr<HostedMatch> match = find(id);
+        if (!match) {
+            sendError(*client, NetError::NO_MATCH, id);
+            return;
+        }
+        std::lock_guard<std::mutex> guard(match->lock);
+        if (match->id != id) {
+            sendError(*client, NetError::NO_MATCH, id);
+            return;
+        }
+        if (match->seats[match->toMove] != client) {
+            sendError(*client, NetError::NOT_YOUR_TURN, id);
+            return;
+        }
+        if (match->winner() >= 0) {
+            sendError(*client, NetError::GAME_OVER, id);
+            return;
+        }
+        Player& mover = match->players[match->toMove];
+        bool again = match->matrix.takeTurn(mover, match->players[1 - match->toMove], action);
+        match->matrix.getEvents().clear();
+        if (!again && match->winner() < 0) match->toMove = static_cast<uint8_t>(1 - match->toMove);
+        ++match->ply;
+        ++actionCount;
+
+        NetMoved moved = {static_cast<uint8_t>(NetMessage::MOVED), action, match->toMove,
+                          static_cast<int8_t>(match->winner()), id, match->ply, {}, {}, {}};
+        for (int p = 0; p < 2; ++p) {
+            const Player& player = match->players[p];
+            moved.cell[p] = static_cast<int32_t>(match->matrix.cellOf(player.getCurrentPosition()));
+            moved.held[p] = static_cast<uint8_t>(player.getHeldPower());
+            moved.active[p] = static_cast<uint8_t>(player.getActivePower());
+        }
+        client->send(&moved, sizeof(moved));
+        for (const auto& seat : match->seats) {
+            if (seat && seat != client) seat->send(&moved, sizeof(moved));
+        }
+    }
+
+    void leave(const std::shared_ptr<MatchClient>& client, uint32_t id) {
+        client->matches.erase(id);
+        std::shared_ptr<HostedMatch> match = find(id);
+        if (!match) return;
+        bool empty;
+        {
+            std::lock_guard<std::mutex> guard(match->lock);
+            if (match->id != id) return;
+            for (int seat = 0; seat < 2; ++seat) {
+                if (match->seats[seat] != client) continue;
+                match->seats[seat] = nullptr;
+                const std::shared_ptr<MatchClient>& other = match->seats[1 - seat];
+                if (other && other != client) sendRef(*other, NetMessage::LEFT, static_cast<uint8_t>(seat), id);
+            }
+            empty = !match->seats[0] && !match->seats[1];
+        }
+        if (!empty) return;
+        {
+            Shard& shard = shardOf(id);
+            std::lock_guard<std::mutex> guard(shard.lock);
+            if (!shard.matches.erase(id)) return;
+        }
+        --liveMatches;
+        std::lock_guard<std::mutex> guard(spareLock);
+        if (spareMatches.size() < NET_SPARE_MATCHES) spareMatches.push_back(std::move(match));
+    }
+
+public:
+    // Handles every whole message at the start of data and returns the bytes
+    // used; the rest is an incomplete message to retry with more bytes.
+    // NET_PROTOCOL_ERROR means the stream is not this protocol: drop the client.
+    size_t consume(const std::shared_ptr<MatchClient>& client, const uint8_t* data, size_t size) {
+        size_t used = 0;
+        while (used < size) {
+            size_t length = netMessageSize(data[used]);
+            if (length == 0) return NET_PROTOCOL_ERROR;
+            if (size - used < length) break;
+            const uint8_t* message = data + used;
+            used += length;
+            NetMatchRef ref;
+            switch (static_cast<NetMessage>(message[0])) {
+                case NetMessage::CREATE: {
+                    NetCreate request;
+                    std::memcpy(&request, message, sizeof(request));
+                    create(client, request);
+                    break;
+                }
+                case NetMessage::JOIN:
+                    std::memcpy(&ref, message, sizeof(ref));
+                    join(client, ref.match);
+                    break;
+                case NetMessage::ACTION:
+                    std::memcpy(&ref, message, sizeof(ref));
+                    act(client, ref.match, ref.action);
+                    break;
+                case NetMessage::LEAVE:
+                    std::memcpy(&ref, message, sizeof(ref));
+                    leave(client, ref.match);
+                    break;
+                default:
+                    return NET_PROTOCOL_ERROR; // Server-to-client messages
+            }
+        }
+        return used;
+    }
+
+    // Leaves every match the client sits in, as if it had sent LEAVE for each
+    void disconnect(const std::shared_ptr<MatchClient>& client) {
+        std::vector<uint32_t> held(client->matches.begin(), client->matches.end());
+        for (uint32_t id : held) leave(client, id);
+    }
+
+    int64_t getMatchCount() const {
+        return liveMatches;
+    }
+
+    uint64_t getActionCount() const {
+        return actionCount;
+    }
+};
+
+// Board fairness. placeTreasure(true) puts the treasure at the same path
+// distance from both starts, but a board can still favour one player: the
+// even race may only exist through a portal that one of them has to use, or
+// one start may sit next to a power pickup. Every measure is in cells; the
+// limits take them as a fraction of the race, the mean path to the treasure.
+struct FairnessReport {
+    int raceLength = -1;     // Mean path from the starts to the treasure; -1 when one cannot reach it
+    int pathDifference = 0;  // Between the two paths to the treasure
+    int portalShortcut = 0;  // Between the cells portals save each player on the way
+    int powerDifference = 0; // Between the paths to each player's nearest pickup
+    double score = 1;        // Largest of the three over raceLength; 0 is perfectly even
+    bool fair = false;
+};
+
+struct FairnessLimits {
+    int maxPathDifference = 0;
+    double maxPortalShortcut = 0.25;
+    double maxPowerDifference = 0.25;
+};
+
+inline FairnessReport analyzeFairness(nodeMatrix& matrix, const FairnessLimits& limits = FairnessLimits()) {
+    FairnessReport report;
+    int64_t treasure = matrix.cellOf(matrix.getTreasure().getPosition());
+    if (treasure < 0) return report;
+    const std::vector<int>& from1 = matrix.getDistanceField(DistanceSource::PLAYER1_START).getDistances();
+    const std::vector<int>& from2 = matrix.getDistanceField(DistanceSource::PLAYER2_START).getDistances();
+    int path1 = from1[treasure];
+    int path2 = from2[treasure];
+    if (path1 < 0 || path2 < 0) return report;
+    report.raceLength = (path1 + path2) / 2;
+    report.pathDifference = std::abs(path1 - path2);
+
+    // The same race with the portals shut; without portals paths run both
+    // ways, so one field from the treasure gives both
+    MazeView walls = matrix.getView();
+    walls.features = nullptr;
+    DistanceField fromTreasure;
+    fromTreasure.compute(walls, &treasure, 1);
+    int walls1 = fromTreasure.getDistances()[matrix.cellOf(matrix.getPlayer1Start())];
+    int walls2 = fromTreasure.getDistances()[matrix.cellOf(matrix.getPlayer2Start())];
+    report.portalShortcut = std::abs((walls1 - path1) - (walls2 - path2));
+
+    int nearest1 = -1;
+    int nearest2 = -1;
+    for (const Power& power : matrix.getPowers()) {
+        int64_t cell = matrix.cellOf(power.getPosition());
+        if (cell < 0 || !power.isPowerPresent()) continue;
+        if (from1[cell] >= 0 && (nearest1 < 0 || from1[cell] < nearest1)) nearest1 = from1[cell];
+        if (from2[cell] >= 0 && (nearest2 < 0 || from2[cell] < nearest2)) nearest2 = from2[cell];
+    }
+    if ((nearest1 < 0) != (nearest2 < 0)) report.powerDifference = report.raceLength; // Only one can reach a pickup
+    else report.powerDifference = std::abs(nearest1 - nearest2);
+
+    double race = std::max(1, report.raceLength);
+    report.score = std::max({report.pathDifference, report.portalShortcut, report.powerDifference}) / race;
+    report.fair = report.pathDifference <= limits.maxPathDifference
+               && report.portalShortcut <= limits.maxPortalShortcut * race
+               && report.powerDifference <= limits.maxPowerDifference * race;
+    return report;
+}
+
+const size_t BOARD_POOL_SIZE = 2;         // Boards the game keeps ready
+const int BOARD_POOL_MAX_ATTEMPTS = 64;   // Boards tried before the fairest of them is kept anyway
+
+// Keeps up to capacity fair boards ready, built on a background thread, so a
+// new match starts without waiting for generation. Boards are built as the
+// game builds them, nodeMatrix(rows, columns, seed) then generateMaze(seed)
+// and placeTreasure(true), from seeds drawn from seed; a kept board's
+// getSeed() rebuilds it. Some sizes have no fair boards at all (no cell is
+// as far from both starts), so after BOARD_POOL_MAX_ATTEMPTS the fairest
+// board tried is kept.
+class BoardPool {
+public:
+    struct Board {
+        std::unique_ptr<nodeMatrix> matrix;
+        FairnessReport fairness;
+    };
+
+private:
+    int rows;
+    int columns;
+    size_t capacity;
+    FairnessLimits limits;
+    Rng seeds;
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<Board> ready;
+    bool stopping = false;
+    uint64_t builtCount = 0;
+    uint64_t rejectedCount = 0;
+    std::thread worker;
+
+    void run() {
+        insideWorkerThread = true; // One core; the game keeps the others
+        Board fairest;
+        int attempts = 0;
+        while (true) {
+            uint64_t seed;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                changed.wait(guard, [this]() { return stopping || ready.size() < capacity; });
+                if (stopping) return;
+                seed = seeds.next();
+            }
+            Board board;
+            board.matrix = std::make_unique<nodeMatrix>(rows, columns, seed);
+            board.matrix->generateMaze(seed);
+            if (!board.matrix->placeTreasure(true)) board.matrix->placeTreasure(false);
+            board.fairness = analyzeFairness(*board.matrix, limits);
+            if (!fairest.matrix || board.fairness.score < fairest.fairness.score) std::swap(board, fairest);
+            ++attempts;
+
+            std::lock_guard<std::mutex> guard(lock);
+            ++builtCount;
+            if (!fairest.fairness.fair && attempts < BOARD_POOL_MAX_ATTEMPTS) {
+                ++rejectedCount;
+                continue;
+            }
+            ready.push_back(std::move(fairest));
+            fairest = Board();
+            attempts = 0;
+            changed.notify_all();
+        }
+    }
+
+public:
+    BoardPool(int rows, int columns, uint64_t seed, size_t capacity = BOARD_POOL_SIZE,
+              const FairnessLimits& limits = FairnessLimits())
+        : rows(rows), columns(columns), capacity(std::max<size_t>(1, capacity)), limits(limits), seeds(seed) {
+        worker = std::thread(&BoardPool::run, this);
+    }
+
+    ~BoardPool() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        changed.notify_all();
+        worker.join();
+    }
+
+    BoardPool(const BoardPool&) = delete;
+    BoardPool& operator=(const BoardPool&) = delete;
+
+    // The oldest ready board; waits only when none is ready yet
+    Board take() {
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [this]() { return !ready.empty(); });
+        Board board = std::move(ready.front());
+        ready.pop_front();
+        changed.notify_all();
+        return board;
+    }
+
+    size_t getReadyCount() {
+        std::lock_guard<std::mutex> guard(lock);
+        return ready.size();
+    }
+
+    uint64_t getBuiltCount() {
+        std::lock_guard<std::mutex> guard(lock);
+        return builtCount;
+    }
+
+    // Boards built and thrown away, as unfair or less fair than one kept
+    uint64_t getRejectedCount() {
+        std::lock_guard<std::mutex> guard(lock);
+        return rejectedCount;
+    }
+};
+
+// Maze library: boards generated and scored once, offline, and stored in one
+// file that is memory-mapped and used in place. Each board keeps its wall
+// planes, portals and pickups, the distance maps from both starts and the
+// treasure, its fairness and the state its engine was left in, so loading it
+// gives the same match as building it from its seed, without carving the
+// maze or running a single search. Everything is in native layout, like
+// replays and the asset bundle, aligned to MAZE_LIBRARY_ALIGNMENT so the
+// planes and maps are read straight from the mapping.
+//
+// File layout: MazeLibraryHeader, the board blocks, then boardCount
+// MazeLibraryEntries (the directory). Files are never changed once written:
+// MazeLibraryWriter writes a new one next to the old and renames it over, so
+// any number of processes can map a library, and one that maps it while it
+// is being rebuilt keeps reading the complete old file.
+const uint32_t MAZE_LIBRARY_VERSION = 1;
+const size_t MAZE_LIBRARY_ALIGNMENT = 64;
+const int MAZE_LIBRARY_FIELDS = 3; // DistanceSource PLAYER1_START, PLAYER2_START and TREASURE
+
+struct MazeLibraryHeader {
+    char magic[8];            // "MZLIBRRY"
+    uint32_t version;
+    uint32_t entrySize;       // sizeof(MazeLibraryEntry) of the build that wrote it
+    int32_t rows;             // Every board of a library has the same size
+    int32_t columns;
+    uint64_t boardCount;
+    uint64_t directoryOffset;
+    uint64_t fileSize;
+};
+
+struct MazeLibraryEntry {
+    uint64_t seed;            // nodeMatrix seed; also what the game prints and replays store
+    uint64_t mazeSeed;
+    double mazeBraid;
+    uint64_t mazeChecksum;
+    uint64_t rngState[4];     // The match engine once the board was built
+    int64_t treasureCell;     // -1 without a treasure
+    uint64_t wallsOffset;     // East wall plane, then the south one
+    uint64_t fieldsOffset[MAZE_LIBRARY_FIELDS]; // int32 per cell, -1 where unreachable
+    uint64_t featuresOffset;  // portalCount portals then pickupCount pickups, as ReplayFeatures
+    uint32_t portalCount;
+    uint32_t pickupCount;
+    int32_t raceLength;       // FairnessReport of the board
+    int32_t pathDifference;
+    int32_t portalShortcut;
+    int32_t powerDifference;
+    double fairnessScore;
+    uint32_t fair;
+    uint32_t padding;
+};
+
+// Writes a maze library: add() each board as soon as it is built, then
+// finish(). The file only appears under its name once it is complete.
+class MazeLibraryWriter {
+private:
+    std::string path;
+    std::string partialPath;
+    std::FILE* file = nullptr;
+    MazeLibraryHeader header = {};
+    std::vector<MazeLibraryEntry> entries;
+    uint64_t offset = 0;
+
+    bool write(const void* data, size_t bytes) {
+        offset += bytes;
+        return std::fwrite(data, 1, bytes, file) == bytes;
+    }
+
+    bool align() {
+        static const char zeros[MAZE_LIBRARY_ALIGNMENT] = {};
+        return write(zeros, (MAZE_LIBRARY_ALIGNMENT - offset % MAZE_LIBRARY_ALIGNMENT) % MAZE_LIBRARY_ALIGNMENT);
+    }
+
+    bool fail() {
+        std::fclose(file);
+        file = nullptr;
+        std::remove(partialPath.c_str());
+        return false;
+    }
+
+public:
+    ~MazeLibraryWriter() {
+        if (file) fail();
+    }
+
+    bool open(const std::string& libraryPath, int rows, int columns) {
+        if (file) fail();
+        path = libraryPath;
+        // Unique, so concurrent rebuilds of one library never share a file
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), ".%016llx.partial", static_cast<unsigned long long>(Rng::randomSeed()));
+        partialPath = path + suffix;
+        file = std::fopen(partialPath.c_str(), "wb");
+        if (!file) return false;
+        header = {};
+        std::copy_n("MZLIBRRY", 8, header.magic);
+        header.version = MAZE_LIBRARY_VERSION;
+        header.entrySize = sizeof(MazeLibraryEntry);
+        header.rows = rows;
+        header.columns = columns;
+        entries.clear();
+        offset = 0;
+        return write(&header, sizeof(header)) || fail(); // Rewritten by finish()
+    }
+
+    // Stores the board as it is now; build it with generateMaze and
+    // placeTreasure and add it before anything is played on it
+    bool add(nodeMatrix& matrix, const FairnessReport& fairness) {
+        if (!file || matrix.getRows() != header.rows || matrix.getColumns() != header.columns) return false;
+        MazeLibraryEntry entry = {};
+        entry.seed = matrix.getSeed();
+        entry.mazeSeed = matrix.getMazeSeed();
+        entry.mazeBraid = matrix.getMazeBraid();
+        entry.mazeChecksum = matrix.getMazeChecksum();
+        matrix.getRng().getState(entry.rngState);
+        entry.treasureCell = matrix.cellOf(matrix.getTreasure().getPosition());
+        entry.portalCount = static_cast<uint32_t>(matrix.getPortals().size());
+        entry.pickupCount = static_cast<uint32_t>(matrix.getPowers().size());
+        entry.raceLength = fairness.raceLength;
+        entry.pathDifference = fairness.pathDifference;
+        entry.portalShortcut = fairness.portalShortcut;
+        entry.powerDifference = fairness.powerDifference;
+        entry.fairnessScore = fairness.score;
+        entry.fair = fairness.fair;
+
+        MazeView view = matrix.getView();
+        size_t words = static_cast<size_t>(view.rows) * view.wordsPerRow;
+        bool written = align();
+        entry.wallsOffset = offset;
+        written = written && write(view.eastWalls, words * sizeof(uint64_t)) && write(view.southWalls, words * sizeof(uint64_t));
+        for (int f = 0; f < MAZE_LIBRARY_FIELDS; ++f) {
+            const std::vector<int>& distances = matrix.getDistanceField(static_cast<DistanceSource>(f)).getDistances();
+            written = written && align();
+            entry.fieldsOffset[f] = offset;
+            written = written && write(distances.data(), distances.size() * sizeof(int32_t));
+        }
+        std::vector<ReplayFeature> features;
+        for (const Portal& portal : matrix.getPortals()) {
+            features.push_back({matrix.cellOf(portal.getPortalAPosition()), matrix.cellOf(portal.getPortalBPosition())});
+        }
+        for (const Power& pickup : matrix.getPowers()) {
+            features.push_back({matrix.cellOf(pickup.getPosition()), static_cast<int64_t>(pickup.getPowerType())});
+        }
+        written = written && align();
+        entry.featuresOffset = offset;
+        written = written && write(features.data(), features.size() * sizeof(ReplayFeature));
+        if (!written) return fail();
+        entries.push_back(entry);
+        return true;
+    }
+
+    size_t getBoardCount() const {
+        return entries.size();
+    }
+
+    // Completes the file and puts it in place of any library of that name
+    bool finish() {
+        if (!file) return false;
+        bool written = align();
+        header.boardCount = entries.size();
+        header.directoryOffset = offset;
+        written = written && write(entries.data(), entries.size() * sizeof(MazeLibraryEntry));
+        header.fileSize = offset;
+        written = written && std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, file) == 1;
+        if (std::fclose(file) != 0) written = false;
+        file = nullptr;
+#ifdef _WIN32
+        std::remove(path.c_str()); // rename does not replace on Windows
+#endif
+        if (!written || std::rename(partialPath.c_str(), path.c_str()) != 0) {
+            std::remove(partialPath.c_str());
+            return false;
+        }
+        return true;
+    }
+};
+
+// Read-only access to a maze library. open() maps the file; attach() takes
+// bytes mapped by the caller. Only the header and the directory are checked;
+// boards are handed out as pointers into the mapping.
+class MazeLibrary {
+public:
+    // One board in place. maze has no feature index (bare walls); portals
+    // and pickups are listed as in a replay.
+    struct Board {
+        const MazeLibraryEntry* entry;
+        MazeView maze;
+        const int32_t* distances[MAZE_LIBRARY_FIELDS]; // Indexed by DistanceSource
+        const ReplayFeature* portals;
+        const ReplayFeature* pickups;
+    };
+
+private:
+    const unsigned char* bytes = nullptr;
+    size_t byteCount = 0;
+    const MazeLibraryHeader* header = nullptr;
+    const MazeLibraryEntry* directory = nullptr;
+    void* mapping = nullptr;              // Set when open() mapped the file
+    std::vector<unsigned char> fileCopy;  // open() on Windows reads the file instead
+
+    bool inside(uint64_t offset, uint64_t size, size_t alignment) const {
+        return offset % alignment == 0 && offset <= byteCount && size <= byteCount - offset;
+    }
+
+public:
+    MazeLibrary() = default;
+    MazeLibrary(const MazeLibrary&) = delete;
+    MazeLibrary& operator=(const MazeLibrary&) = delete;
+
+    ~MazeLibrary() {
+        close();
+    }
+
+    bool open(const std::string& path) {
+        close();
+#ifdef _WIN32
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) return false;
+        bool read = std::fseek(file, 0, SEEK_END) == 0;
+        long size = read ? std::ftell(file) : -1;
+        read = size > 0 && std::fseek(file, 0, SEEK_SET) == 0;
+        if (read) {
+            fileCopy.resize(static_cast<size_t>(size));
+            read = std::fread(fileCopy.data(), 1, fileCopy.size(), file) == fileCopy.size();
+        }
+        std::fclose(file);
+        return read && attach(fileCopy.data(), fileCopy.size());
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        struct stat info;
+        void* view = MAP_FAILED;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            // Shared and read-only: every process reading the library uses the same page cache pages
+            view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        }
+        ::close(fd); // The mapping keeps the file alive
+        if (view == MAP_FAILED) return false;
+        mapping = view;
+        byteCount = static_cast<size_t>(info.st_size);
+        return attach(static_cast<const unsigned char*>(view), byteCount);
+#endif
+    }
+
+    // Uses size bytes at data, which must stay valid and unchanged while the
+    // library is in use. False when they do not hold a library of this build.
+    bool attach(const unsigned char* data, size_t size) {
+        bytes = data;
+        byteCount = size;
+        header = reinterpret_cast<const MazeLibraryHeader*>(data);
+        bool valid = size >= sizeof(MazeLibraryHeader) && reinterpret_cast<uintptr_t>(data) % alignof(MazeLibraryEntry) == 0 &&
+                     std::equal(header->magic, header->magic + 8, "MZLIBRRY") && header->version == MAZE_LIBRARY_VERSION &&
+                     header->entrySize == sizeof(MazeLibraryEntry) && header->fileSize == size && header->rows > 0 &&
+                     header->columns > 0 && header->boardCount <= size / sizeof(MazeLibraryEntry) &&
+                     inside(header->directoryOffset, header->boardCount * sizeof(MazeLibraryEntry), alignof(MazeLibraryEntry));
+        if (valid) directory = reinterpret_cast<const MazeLibraryEntry*>(data + header->directoryOffset);
+        uint64_t cells = valid ? static_cast<uint64_t>(header->rows) * header->columns : 0;
+        uint64_t wallBytes = valid ? 2 * static_cast<uint64_t>(header->rows) * ((header->columns + 63) / 64) * sizeof(uint64_t) : 0;
+        for (uint64_t i = 0; valid && i < header->boardCount; ++i) {
+            const MazeLibraryEntry& entry = directory[i];
+            valid = inside(entry.wallsOffset, wallBytes, alignof(uint64_t)) &&
+                    entry.pickupCount <= static_cast<uint32_t>(MAX_POWER_PICKUPS) &&
+                    inside(entry.featuresOffset, (static_cast<uint64_t>(entry.portalCount) + entry.pickupCount) * sizeof(ReplayFeature), alignof(ReplayFeature)) &&
+                    entry.treasureCell >= -1 && entry.treasureCell < static_cast<int64_t>(cells);
+            for (int f = 0; valid && f < MAZE_LIBRARY_FIELDS; ++f) valid = inside(entry.fieldsOffset[f], cells * sizeof(int32_t), alignof(int32_t));
+        }
+        if (!valid) close();
+        return valid;
+    }
+
+    void close() {
+#ifndef _WIN32
+        if (mapping) munmap(mapping, byteCount);
+#endif
+        mapping = nullptr;
+        fileCopy.clear();
+        fileCopy.shrink_to_fit();
+        bytes = nullptr;
+        byteCount = 0;
+        header = nullptr;
+        directory = nullptr;
+    }
+
+    bool isOpen() const {
+        return header != nullptr;
+    }
+
+    size_t getBoardCount() const {
+        return header ? static_cast<size_t>(header->boardCount) : 0;
+    }
+
+    int getRows() const {
+        return header ? header->rows : 0;
+    }
+
+    int getColumns() const {
+        return header ? header->columns : 0;
+    }
+
+    const MazeLibraryEntry& getEntry(size_t index) const {
+        return directory[index];
+    }
+
+    Board getBoard(size_t index) const {
+        const MazeLibraryEntry& entry = directory[index];
+        Board board;
+        board.entry = &entry;
+        int wordsPerRow = (header->columns + 63) / 64;
+        const uint64_t* walls = reinterpret_cast<const uint64_t*>(bytes + entry.wallsOffset);
+        board.maze = {header->rows, header->columns, wordsPerRow, walls, walls + static_cast<size_t>(header->rows) * wordsPerRow, nullptr};
+        for (int f = 0; f < MAZE_LIBRARY_FIELDS; ++f) board.distances[f] = reinterpret_cast<const int32_t*>(bytes + entry.fieldsOffset[f]);
+        board.portals = reinterpret_cast<const ReplayFeature*>(bytes + entry.featuresOffset);
+        board.pickups = board.portals + entry.portalCount;
+        return board;
+    }
+
+    // The board a match seed picks; every board is equally likely
+    size_t pick(uint64_t seed) const {
+        return static_cast<size_t>(Rng::mix(seed, 0x11B) % std::max<uint64_t>(1, getBoardCount()));
+    }
+
+    // Puts board index on matrix as nodeMatrix(rows, columns, seed),
+    // generateMaze and placeTreasure left it, distance maps included. The
+    // wall planes and the maps are copied; nothing is generated or searched.
+    // A pickup with a power type that does not exist, or a feature or
+    // treasure cell off the board, is refused before matrix is touched. False
+    // too when the stored walls and portals no longer match the checksum.
+    bool load(size_t index, nodeMatrix& matrix) const {
+        Board board = getBoard(index);
+        const MazeLibraryEntry& entry = *board.entry;
+        int64_t cells = static_cast<int64_t>(header->rows) * header->columns;
+        auto onBoard = [cells](int64_t cell) { return cell >= -1 && cell < cells; };
+        auto position = [this](int64_t cell) {
+            return cell < 0 ? std::make_pair(-1, -1) : std::make_pair(static_cast<int>(cell / header->columns), static_cast<int>(cell % header->columns));
+        };
+        if (!onBoard(entry.treasureCell)) return false;
+        std::vector<Portal> portals;
+        std::vector<Power> pickups;
+        for (uint32_t i = 0; i < entry.portalCount; ++i) {
+            if (!onBoard(board.portals[i].cell) || !onBoard(board.portals[i].value)) return false;
+            portals.emplace_back(position(board.portals[i].cell), position(board.portals[i].value));
+        }
+        for (uint32_t i = 0; i < entry.pickupCount; ++i) {
+            int64_t type = board.pickups[i].value;
+            if (!onBoard(board.pickups[i].cell) ||
+                type < static_cast<int64_t>(PowerType::DOUBLE_PLAY) || type > static_cast<int64_t>(PowerType::JUMP_WALL)) {
+                return false;
+            }
+            pickups.emplace_back(position(board.pickups[i].cell), static_cast<PowerType>(type));
+        }
+        matrix.reset(header->rows, header->columns, entry.seed);
+        matrix.loadMaze(board.maze.eastWalls, board.maze.southWalls, entry.mazeSeed, entry.mazeBraid);
+        matrix.getTreasure().setPosition(position(entry.treasureCell));
+        matrix.setFeatures(portals, pickups);
+        matrix.getRng().setState(entry.rngState);
+        for (int f = 0; f < MAZE_LIBRARY_FIELDS; ++f) matrix.setDistanceField(static_cast<DistanceSource>(f), board.distances[f]);
+        return matrix.getMazeChecksum() == entry.mazeChecksum;
+    }
+};
+
+#endif
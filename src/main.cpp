@@ -2,26 +2,119 @@
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_ttf.h>
 
+#include "UI_ImageLoader.h"
 #include "UI_MAIN.h"
+#include "UI_Board.h"
+#include "UI_Cell.h"
 #include "UI_TitleScreen.h"
 #include "UI_Treasure.h"
 #include "UI_Player.h"
+#include "UI_Profiler.h"
+#include "UI_MappedFile.h"
+#include "backend.h"
+#include <chrono>
+#include <cstring>
+#include <future>
 #include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
 using namespace std;
 
+const Uint32 WIN_SCREEN_MS = 5000;
+const int AI_DEFAULT_BUDGET_MS = 300; // Thinking time per computer move
+const int AI_POLL_MS = 10;            // Event wait while the computer is thinking
+const double REPLAY_DEFAULT_SPEED = 4; // Actions per second when playing a replay back
+
 int main(int argc, char* argv[]) {
     enum GameState {
         TITLE_SCREEN, MAIN_PROGRAM, WIN_SCREEN
     };
 
+    // --novsync turns vsync off, --fps N caps the frame rate without vsync,
+    // --seed S replays a board, --rows R / --columns C set the board size,
+    // --ai makes player 2 the computer (--ai-ms N thinking time per move),
+    // --record FILE saves the match as a replay, --replay FILE plays one back
+    // (--replay-speed N actions per second, 0 = one per frame; --replay-from N
+    // starts at action N), --library FILE plays a board of a maze library
+    // (tools/mazelib) picked by the seed, --bake-assets writes the asset
+    // bundle and exits
+    bool vsync = true;
+    bool computerPlayer2 = false;
+    MctsOptions aiOptions;
+    aiOptions.budgetMs = AI_DEFAULT_BUDGET_MS;
+    int boardRows = rows;
+    int boardColumns = columns;
+    int targetFps = DEFAULT_TARGET_FPS;
+    uint64_t seed = Rng::randomSeed();
+    bool seedGiven = false;
+    string recordPath, replayPath, libraryPath;
+    double replaySpeed = REPLAY_DEFAULT_SPEED;
+    long long replayFrom = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--novsync")) vsync = false;
+        else if (!strcmp(argv[i], "--fps") && i + 1 < argc) targetFps = max(0, stoi(argv[++i]));
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            seed = stoull(argv[++i]);
+            seedGiven = true;
+        }
+        else if (!strcmp(argv[i], "--rows") && i + 1 < argc) boardRows = max(2, stoi(argv[++i]));
+        else if (!strcmp(argv[i], "--columns") && i + 1 < argc) boardColumns = max(2, stoi(argv[++i]));
+        else if (!strcmp(argv[i], "--ai")) computerPlayer2 = true;
+        else if (!strcmp(argv[i], "--ai-ms") && i + 1 < argc) aiOptions.budgetMs = max(1, stoi(argv[++i]));
+        else if (!strcmp(argv[i], "--record") && i + 1 < argc) recordPath = argv[++i];
+        else if (!strcmp(argv[i], "--replay") && i + 1 < argc) replayPath = argv[++i];
+        else if (!strcmp(argv[i], "--library") && i + 1 < argc) libraryPath = argv[++i];
+        else if (!strcmp(argv[i], "--replay-speed") && i + 1 < argc) replaySpeed = max(0.0, stod(argv[++i]));
+        else if (!strcmp(argv[i], "--replay-from") && i + 1 < argc) replayFrom = max(0LL, stoll(argv[++i]));
+        else if (!strcmp(argv[i], "--bake-assets")) {
+            imageLoader.generatePathsForVector();
+            return imageLoader.writeBundle(imageLoader.imagePaths, ASSET_BUNDLE_PATH) ? 0 : 1;
+        }
+    }
+
+    // A replay brings its own board and moves; nobody plays
+    Replay replay;
+    bool replaying = !replayPath.empty();
+    if (replaying) {
+        if (!replay.load(replayPath)) {
+            cerr << "Cannot read the replay " << replayPath << endl;
+            return -1;
+        }
+        boardRows = replay.getHeader().rows;
+        boardColumns = replay.getHeader().columns;
+        seed = replay.getHeader().seed;
+        computerPlayer2 = false;
+    }
+
+    // A maze library is mapped and its boards used in place; it sets the size
+    UI_MappedFile libraryFile;
+    MazeLibrary library;
+    if (!replaying && !libraryPath.empty()) {
+        if (!libraryFile.open(libraryPath) || !library.attach(libraryFile.data(), libraryFile.size()) ||
+            library.getBoardCount() == 0) {
+            cerr << "Cannot read the maze library " << libraryPath << endl;
+            return -1;
+        }
+        boardRows = library.getRows();
+        boardColumns = library.getColumns();
+    }
+
+    // Fair boards are built in the background from here on, so Play starts
+    // the match at once; --seed, --replay and --library set up their one
+    // board themselves
+    optional<BoardPool> boardPool;
+    if (!replaying && !seedGiven && !library.isOpen()) boardPool.emplace(boardRows, boardColumns, seed);
+
     {
         UI_MAIN uiMain;
         UI_TitleScreen uiTitleScreen;
         UI_Treasure uiWinScreen;
         UI_Player uiPlayer;
+        UI_Profiler profiler; // Declared after uiMain so its textures go before the renderer
 
 
-        if (!uiMain.initialize()) {
+        if (!uiMain.initialize(vsync)) {
             cerr << "Failed to initialize UI_MAIN." << endl;
             return -1;
         }
@@ -30,66 +123,220 @@ int main(int argc, char* argv[]) {
         SDL_Renderer* renderer = uiMain.getRenderer();
         SDL_Event event;
         bool running = true;
-        char direction = 'x'; 
+        bool needsRedraw = true;
         int playerTurn = 1;
+        int winnerPlayer = 0;
+        Uint32 winScreenEnd = 0;
+        vector<pair<int, char>> pendingMoves; // (player, action) read this frame
 
-        int rowTest = 5;
-        int colTest = 5;
-        int** testMatrix = new int*[rowTest]; 
-        for (int i = 0; i < rowTest; i++) {
-            testMatrix[i] = new int[colTest];
+        // Backend match. A pooled board replaces this one when Play is
+        // clicked; pass the printed seed back with --seed to replay it.
+        nodeMatrix matrix(boardRows, boardColumns, seed);
+        if (replaying) {
+            if (!replay.setUpBoard(matrix)) {
+                cerr << "This build no longer generates the board of " << replayPath << endl;
+                return -1;
+            }
+        } else if (library.isOpen()) {
+            if (!library.load(library.pick(seed), matrix)) {
+                cerr << "The maze library " << libraryPath << " is damaged" << endl;
+                return -1;
+            }
+        } else if (!boardPool) {
+            matrix.generateMaze(seed);
+            if (!matrix.placeTreasure(true)) {
+                cerr << "No cell is equally far from both players on seed " << seed
+                     << "; the treasure was placed by grid distance instead" << endl;
+                matrix.placeTreasure(false);
+            }
         }
+        Player player1("Player 1", matrix.getPlayer1Start(), PlayerTurn::PLAYER1);
+        Player player2("Player 2", matrix.getPlayer2Start(), PlayerTurn::PLAYER2);
+        ConsoleEventSink console(player1.getPlayerID(), player2.getPlayerID());
+        ReplayRecorder recorder;
+        MctsPlayer ai(aiOptions);
+        future<char> aiMove; // Valid while the computer is thinking
+        UI_Camera camera;
+        int viewWidth, viewHeight;
 
-        testMatrix[0][0] = 1;
-        testMatrix[1][3] = 3;
-        testMatrix[4][3] = 4;
-        testMatrix[3][0] = 5;
-        testMatrix[1][4] = 6;
-        testMatrix[2][2] = 7;
+        // Sets the match up on the current board. Small boards start fully
+        // visible; large ones start at full size on player 1.
+        auto startMatch = [&]() {
+            cout << "Match seed: " << matrix.getSeed() << endl;
+            player1 = Player("Player 1", matrix.getPlayer1Start(), PlayerTurn::PLAYER1);
+            player2 = Player("Player 2", matrix.getPlayer2Start(), PlayerTurn::PLAYER2);
+            recorder.start(matrix, player1, player2, PlayerTurn::PLAYER1);
+            aiOptions.seed = matrix.getSeed();
+            ai = MctsPlayer(aiOptions);
+            SDL_GetRendererOutputSize(renderer, &viewWidth, &viewHeight);
+            camera.setViewport(viewWidth, viewHeight);
+            camera.setBoardSize(matrix.getRows(), matrix.getColumns());
+            camera.fitBoard();
+            if (camera.getCellPixels() < LOD_CELL_PIXELS) {
+                camera.zoomAt(CELL_SIZE / camera.getCellPixels(), viewWidth / 2, viewHeight / 2);
+                camera.setFollowing(true);
+            }
+            camera.follow(player1.getCurrentPosition().first, player1.getCurrentPosition().second);
+            uiMain.invalidateBoard();
+        };
+        if (!boardPool) startMatch();
+        optional<ReplayPlayer> playback;
+        Uint32 nextReplayStep = 0;
+        if (replaying) {
+            playback.emplace(replay, matrix, player1, player2);
+            playback->seek(static_cast<uint64_t>(replayFrom));
+            playerTurn = playback->getToMove() == PlayerTurn::PLAYER1 ? 1 : 2;
+        }
 
         while (running) {
-            // Renderer Section (renders the different GameStates)
-            if (currentGameState == TITLE_SCREEN) {
-                uiTitleScreen.runTitleScreen(renderer);
-            } else if (currentGameState == MAIN_PROGRAM) {
-                // Initialize Backend
-                uiMain.runMainProgram(renderer, testMatrix, rowTest, colTest);
+            // Input Section: sleep until an event arrives. The timeout only
+            // matters while the win screen counts down, so an idle game stays
+            // blocked here and uses no CPU.
+            int timeout = aiMove.valid() ? AI_POLL_MS : IDLE_WAIT_MS;
+            if (currentGameState == MAIN_PROGRAM && playback && !playback->atEnd()) {
+                Uint32 now = SDL_GetTicks();
+                timeout = nextReplayStep > now ? min<int>(timeout, static_cast<int>(nextReplayStep - now)) : 0;
             }
-            else if (currentGameState == WIN_SCREEN) {
-                uiWinScreen.runWinScreen(renderer, 1);
+            if (currentGameState == WIN_SCREEN) {
+                Uint32 now = SDL_GetTicks();
+                timeout = winScreenEnd > now ? min<int>(timeout, static_cast<int>(winScreenEnd - now)) : 0;
             }
-        
-            // Event Handler Section (handles different events to switch between GameStates)
-            while (SDL_PollEvent(&event) != 0) {
+            bool hasEvent = !needsRedraw ? SDL_WaitEventTimeout(&event, timeout) != 0 : SDL_PollEvent(&event) != 0;
+            profiler.startFrame();
+            for (; hasEvent; hasEvent = SDL_PollEvent(&event) != 0) {
                 if (event.type == SDL_QUIT) {
                     running = false;
                 }
+                if (event.type == SDL_RENDER_TARGETS_RESET || event.type == SDL_RENDER_DEVICE_RESET) {
+                    uiMain.invalidateBoard();
+                    needsRedraw = true;
+                }
+                if (event.type == SDL_WINDOWEVENT) {
+                    needsRedraw = true;
+                }
+                if (event.type == SDL_KEYDOWN && profiler.handleKey(event.key.keysym.sym)) {
+                    needsRedraw = true;
+                    continue;
+                }
 
                 if (currentGameState == TITLE_SCREEN) {
                     if (uiTitleScreen.buttonClick(event)) {
+                        if (boardPool) {
+                            BoardPool::Board board = boardPool->take();
+                            matrix = std::move(*board.matrix);
+                            cout << "Board fairness score: " << board.fairness.score << endl;
+                            startMatch();
+                        }
                         currentGameState = MAIN_PROGRAM;
+                        needsRedraw = true;
                     }
-                } 
-                
+                }
+
                 else if (currentGameState == MAIN_PROGRAM) {
-                    while(direction == 'x') {
-                        if (playerTurn == 1) {
-                            direction = uiPlayer.processInputP1(direction);
-                        }
-                        else if (playerTurn == 2) {
-                            direction = uiPlayer.processInputP2(direction);
+                    if (camera.handleEvent(event)) {
+                        needsRedraw = true;
+                    }
+                    bool computerTurn = computerPlayer2 && playerTurn == 2;
+                    if (event.type == SDL_KEYDOWN && !computerTurn && !replaying) {
+                        char action = uiPlayer.directionForKey(event.key.keysym.sym, playerTurn);
+                        if (action != 'x') {
+                            pendingMoves.push_back({playerTurn, action});
                         }
-                        // Backend changes
                     }
-                    direction = 'x';
-                    currentGameState = WIN_SCREEN; // Include IF Win Condition
                 }
+            }
 
-                else if (currentGameState == WIN_SCREEN) {
-                    SDL_Delay(5000);
-                    running = false;
+            profiler.endPhase(PHASE_INPUT);
+
+            // Update Section: apply queued actions to the backend. Keys pressed
+            // out of turn in the same frame are dropped; the backend decides
+            // whether the turn passes (powers can give another action).
+            if (currentGameState == MAIN_PROGRAM) {
+                if (aiMove.valid() && aiMove.wait_for(chrono::seconds(0)) == future_status::ready) {
+                    pendingMoves.push_back({2, aiMove.get()});
+                }
+                for (const auto& [mover, action] : pendingMoves) {
+                    if (mover != playerTurn) continue;
+                    Player& player = mover == 1 ? player1 : player2;
+                    Player& opponent = mover == 1 ? player2 : player1;
+                    recorder.record(action);
+                    bool again = matrix.takeTurn(player, opponent, action);
+                    matrix.drainEvents(console);
+                    needsRedraw = true;
+                    if (player1.getHasWon() || player2.getHasWon()) {
+                        winnerPlayer = player1.getHasWon() ? 1 : 2;
+                        currentGameState = WIN_SCREEN;
+                        winScreenEnd = SDL_GetTicks() + WIN_SCREEN_MS;
+                        break;
+                    }
+                    if (!again) playerTurn = playerTurn == 1 ? 2 : 1;
+                }
+                // Replays advance on a timer through the same turn logic
+                if (playback && currentGameState == MAIN_PROGRAM && !playback->atEnd() && SDL_GetTicks() >= nextReplayStep) {
+                    playback->step();
+                    matrix.drainEvents(console);
+                    needsRedraw = true;
+                    nextReplayStep = SDL_GetTicks() + (replaySpeed > 0 ? static_cast<Uint32>(1000 / replaySpeed) : 0);
+                    playerTurn = playback->getToMove() == PlayerTurn::PLAYER1 ? 1 : 2;
+                    if (player1.getHasWon() || player2.getHasWon()) {
+                        winnerPlayer = player1.getHasWon() ? 1 : 2;
+                        currentGameState = WIN_SCREEN;
+                        winScreenEnd = SDL_GetTicks() + WIN_SCREEN_MS;
+                    }
+                    const Player& active = playerTurn == 1 ? player1 : player2;
+                    camera.follow(active.getCurrentPosition().first, active.getCurrentPosition().second);
+                }
+                if (!pendingMoves.empty()) {
+                    const Player& active = playerTurn == 1 ? player1 : player2;
+                    camera.follow(active.getCurrentPosition().first, active.getCurrentPosition().second);
+                }
+                // The computer thinks on other threads while the window stays live;
+                // the maze does not change until its move comes back
+                if (currentGameState == MAIN_PROGRAM && computerPlayer2 && playerTurn == 2 && !aiMove.valid()) {
+                    ai.setPosition(matrix, player2, player1);
+                    aiMove = async(launch::async, [&ai]() { return ai.search(); });
                 }
             }
+            pendingMoves.clear();
+            if (currentGameState == WIN_SCREEN && SDL_GetTicks() >= winScreenEnd) {
+                running = false;
+            }
+
+            profiler.endPhase(PHASE_UPDATE);
+
+            // Renderer Section (renders the different GameStates, once per
+            // change; every frame while the profiler overlay is shown)
+            if (!running || !needsRedraw) {
+                continue;
+            }
+            Uint32 frameStart = SDL_GetTicks();
+            if (currentGameState == TITLE_SCREEN) {
+                uiTitleScreen.runTitleScreen(renderer);
+            } else if (currentGameState == MAIN_PROGRAM) {
+                SDL_GetRendererOutputSize(renderer, &viewWidth, &viewHeight);
+                camera.setViewport(viewWidth, viewHeight);
+                uiMain.runMainProgram(renderer, matrix, player1, player2, camera);
+            }
+            else if (currentGameState == WIN_SCREEN) {
+                uiWinScreen.runWinScreen(renderer, winnerPlayer);
+            }
+            profiler.renderOverlay(renderer);
+            profiler.endPhase(PHASE_RENDER);
+            SDL_RenderPresent(renderer);
+            profiler.endPhase(PHASE_PRESENT);
+            profiler.endFrame();
+            needsRedraw = profiler.isVisible();
+
+            // With vsync the present already waits for the display
+            if (!vsync && targetFps > 0) {
+                Uint32 frameTime = SDL_GetTicks() - frameStart;
+                Uint32 frameBudget = 1000 / targetFps;
+                if (frameTime < frameBudget) SDL_Delay(frameBudget - frameTime);
+            }
+        }
+        if (!recordPath.empty() && !replaying) {
+            if (recorder.save(recordPath)) cout << "Match recorded to " << recordPath << endl;
+            else cerr << "Could not write the replay " << recordPath << endl;
         }
         // All SDL processes are closed
     }
@@ -0,0 +1,199 @@
+// Backend micro-benchmarks on Google Benchmark: board construction, feature
+// spawning, treasure placement, moves through nodeMatrix and GameState,
+// distance fields and path queries, each on square boards of several sizes.
+// Results are machine-readable through the library's own flags:
+//
+//   benchmarks [--benchmark_filter=REGEX] [--benchmark_out=FILE --benchmark_out_format=json]
+//
+// `make bench` runs the suite and writes benchmarks.json. Every board comes
+// from a fixed seed, so runs on one machine compare across builds.
+
+#include "../src/backend.h"
+#include <benchmark/benchmark.h>
+#include <new>
+
+// Every operator new in the process is counted, so benchmarks can report
+// heap allocations per item. GCC takes the free() in the replaced deletes for
+// a mismatch once they are inlined into new-expressions.
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+static std::atomic<uint64_t> heapAllocations{0};
+
+void* operator new(size_t size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+const uint64_t BENCH_SEED = 1;
+const int BENCH_ACTIONS = 4096;   // Scripted actions replayed by the move benchmarks
+const int BENCH_QUERIES = 256;    // Cell pairs cycled through by the path benchmarks
+
+// Square board edges: the default game, then boards the camera has to cull
+static void boardSizes(benchmark::internal::Benchmark* bench) {
+    for (int size : {30, 100, 300, 1000}) bench->Arg(size);
+    bench->Unit(benchmark::kMicrosecond);
+}
+
+static std::vector<char> scriptedActions(uint64_t seed) {
+    Rng rng(seed);
+    std::vector<char> actions(BENCH_ACTIONS);
+    for (char& action : actions) action = gameActions[rng.nextBelow(directionSize)];
+    return actions;
+}
+
+// nodeMatrix construction plus generateMaze with the default braid
+static void BM_BuildMaze(benchmark::State& state) {
+    int size = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        nodeMatrix matrix(size, size, BENCH_SEED);
+        matrix.generateMaze(BENCH_SEED);
+        benchmark::DoNotOptimize(matrix.getMazeChecksum());
+    }
+    state.SetItemsProcessed(state.iterations() * size * size);
+}
+BENCHMARK(BM_BuildMaze)->Apply(boardSizes);
+
+// One portal pair per 10 rows plus 16 pickups, re-drawn every iteration
+static void BM_SpawnFeatures(benchmark::State& state) {
+    int size = static_cast<int>(state.range(0));
+    nodeMatrix matrix(size, size, BENCH_SEED);
+    matrix.generateMaze(BENCH_SEED);
+    for (auto _ : state) {
+        matrix.spawnFeatures(size / 10, 16);
+        benchmark::DoNotOptimize(matrix.getPortals().data());
+    }
+}
+BENCHMARK(BM_SpawnFeatures)->Apply(boardSizes);
+
+// placeTreasure(true) with both start distance fields stale, as on a new board
+static void BM_PlaceTreasure(benchmark::State& state) {
+    int size = static_cast<int>(state.range(0));
+    nodeMatrix matrix(size, size, BENCH_SEED);
+    matrix.generateMaze(BENCH_SEED);
+    bool wall = matrix.hasWall(0, 0, Direction::RIGHT);
+    for (auto _ : state) {
+        matrix.setWall(0, 0, Direction::RIGHT, wall);  // Same wall, new topology version
+        benchmark::DoNotOptimize(matrix.placeTreasure(true));
+    }
+}
+BENCHMARK(BM_PlaceTreasure)->Apply(boardSizes);
+
+// Random WASD through nodeMatrix::movePlayer, events included
+static void BM_MovePlayer(benchmark::State& state) {
+    int size = static_cast<int>(state.range(0));
+    nodeMatrix matrix(size, size, BENCH_SEED);
+    matrix.generateMaze(BENCH_SEED);
+    matrix.placeTreasure(true);
+    matrix.getMoveTable();
+    std::vector<char> actions = scriptedActions(BENCH_SEED);
+    Player player("Player 1", matrix.getPlayer1Start(), PlayerTurn::PLAYER1);
+    for (auto _ : state) {
+        for (char action : actions) matrix.movePlayer(player, action);
+        matrix.getEvents().clear();
+    }
+    state.SetItemsProcessed(state.iterations() * BENCH_ACTIONS);
+}
+BENCHMARK(BM_MovePlayer)->Apply(boardSizes);
+
+// The same walk on a GameState, as the computer player's search makes it
+static void BM_GameStateApply(benchmark::State& state) {
+    int size = static_cast<int>(state.range(0));
+    nodeMatrix matrix(size, size, BENCH_SEED);
+    matrix.generateMaze(BENCH_SEED);
+    matrix.placeTreasure(true);
+    std::vector<char> actions = scriptedActions(BENCH_SEED);
+    Player player1("Player 1", matrix.getPlayer1Start(), PlayerTurn::PLAYER1);
+    Player player2("Player 2", matrix.getPlayer2Start(), PlayerTurn::PLAYER2);
+    GameState start = matrix.snapshot(player1, player2, PlayerTurn::PLAYER1);
+    for (auto _ : state) {
+        GameState s = start;
+        for (char action : actions) {
+            if (s.winner >= 0) s = start;
+            s.apply(action);
+        }
+        benchmark::DoNotOptimize(s.hash);
+    }
+    state.SetItemsProcessed(state.iterations() * BENCH_ACTIONS);
+}
+BENCHMARK(BM_GameStateApply)->Apply(boardSizes);
+
+static void BM_DistanceField(benchmark::State& state) {
+    int size = static_cast<int>(state.range(0));
+    nodeMatrix matrix(size, size, BENCH_SEED);
+    matrix.generateMaze(BENCH_SEED);
+    DistanceField field;
+    MazeView view = matrix.getView();
+    for (auto _ : state) {
+        field.compute(view, {matrix.cellOf(matrix.getPlayer1Start())});
+        benchmark::DoNotOptimize(field.getDistances().data());
+    }
+    state.SetItemsProcessed(state.iterations() * size * size);
+}
+BENCHMARK(BM_DistanceField)->Apply(boardSizes);
+
+// Shortest paths between random cell pairs; the second argument picks A* (0)
+// or jump-point search (1)
+static void BM_FindPath(benchmark::State& state) {
+    int size = static_cast<int>(state.range(0));
+    PathFinder::Method method = state.range(1) ? PathFinder::Method::JUMP_POINT : PathFinder::Method::ASTAR;
+    nodeMatrix matrix(size, size, BENCH_SEED);
+    matrix.generateMaze(BENCH_SEED);
+    Rng rng(BENCH_SEED);
+    std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>> queries(BENCH_QUERIES);
+    for (auto& query : queries) {
+        query.first = {static_cast<int>(rng.nextBelow(size)), static_cast<int>(rng.nextBelow(size))};
+        query.second = {static_cast<int>(rng.nextBelow(size)), static_cast<int>(rng.nextBelow(size))};
+    }
+    size_t next = 0;
+    for (auto _ : state) {
+        const auto& query = queries[next++ % queries.size()];
+        benchmark::DoNotOptimize(matrix.findPath(query.first, query.second, nullptr, true, 0, method));
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(state.range(1) ? "jump point" : "A*");
+}
+BENCHMARK(BM_FindPath)->ArgsProduct({{30, 100, 300, 1000}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+class NullClient : public MatchClient {
+public:
+    void send(const void*, size_t) override {}
+};
+
+// A hosted match from CREATE to LEAVE with a few actions in between: the
+// churn of a busy match server. Ended matches are recycled, so after the
+// first iterations allocs/match should read 0.
+static void BM_HostMatch(benchmark::State& state) {
+    int size = static_cast<int>(state.range(0));
+    MatchHost host;
+    auto client = std::make_shared<NullClient>();
+    std::vector<char> actions = scriptedActions(BENCH_SEED);
+    auto playMatch = [&](uint64_t seed) {
+        NetCreate create = {static_cast<uint8_t>(NetMessage::CREATE), NET_SEAT_BOTH, static_cast<uint16_t>(size),
+                            static_cast<uint16_t>(size), 0, 0, 0, seed};
+        host.consume(client, reinterpret_cast<const uint8_t*>(&create), sizeof(create));
+        uint32_t match = *client->matches.begin();
+        for (int i = 0; i < 16; ++i) {
+            NetMatchRef action = {static_cast<uint8_t>(NetMessage::ACTION), 0, actions[(seed * 16 + i) % actions.size()], 0, match};
+            host.consume(client, reinterpret_cast<const uint8_t*>(&action), sizeof(action));
+        }
+        NetMatchRef leave = {static_cast<uint8_t>(NetMessage::LEAVE), 0, 0, 0, match};
+        host.consume(client, reinterpret_cast<const uint8_t*>(&leave), sizeof(leave));
+    };
+    uint64_t seed = BENCH_SEED;
+    playMatch(seed++);
+    uint64_t allocations = heapAllocations;
+    for (auto _ : state) playMatch(seed++);
+    state.counters["allocs/match"] = benchmark::Counter(static_cast<double>(heapAllocations - allocations) / state.iterations());
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HostMatch)->Arg(10)->Arg(30)->Arg(100)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
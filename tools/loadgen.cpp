@@ -0,0 +1,297 @@
+// Load generator for matchserver. Opens a number of connections, creates
+// matches on them that play both seats, holds them idle for a while (watch
+// the server's memory line), then plays random actions with a window of
+// requests in flight per connection and reports throughput and latency.
+// Finished matches are left and replaced, so the match count stays constant.
+//
+//   loadgen [--unix PATH | --port N] [--connections C] [--matches M]
+//           [--rows R] [--columns C] [--idle SECONDS] [--seconds S]
+//           [--window W] [--seed S] [--verify]
+//
+// --verify rebuilds every board from its seed and checks the server's maze
+// checksum, as a frontend would before drawing it.
+
+#include "../src/backend.h"
+#include <arpa/inet.h>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+struct LoadOptions {
+    std::string unixPath;
+    int port = 7878;
+    int connections = 64;
+    int matches = 10000;
+    int rows = ::rows;
+    int columns = ::columns;
+    double idleSeconds = 2;
+    double seconds = 10;
+    int window = 32;
+    uint64_t seed = 1;
+    bool verify = false;
+};
+
+using Clock = std::chrono::steady_clock;
+
+struct LoadClient {
+    int fd = -1;
+    std::vector<uint8_t> input;
+    std::vector<uint8_t> output;
+    std::vector<uint32_t> matches;
+    std::deque<Clock::time_point> inFlight; // Send times of unanswered actions, in order
+};
+
+struct LoadTotals {
+    long long created = 0;
+    long long actions = 0;
+    long long refused = 0;
+    long long finished = 0;
+    long long badBoards = 0;
+    std::vector<float> latencies; // Microseconds
+};
+
+static int connectTo(const LoadOptions& options) {
+    int fd;
+    int result;
+    if (!options.unixPath.empty()) {
+        fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, options.unixPath.c_str(), sizeof(address.sun_path) - 1);
+        result = ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    } else {
+        fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(options.port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        result = ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    }
+    if (fd >= 0 && result < 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Blocking write of everything queued; the server always reads, so this cannot stall for long
+static bool flushClient(LoadClient& client) {
+    size_t sent = 0;
+    while (sent < client.output.size()) {
+        ssize_t n = ::send(client.fd, client.output.data() + sent, client.output.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    client.output.clear();
+    return true;
+}
+
+template <typename Message>
+static void queue(LoadClient& client, const Message& message) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&message);
+    client.output.insert(client.output.end(), bytes, bytes + sizeof(message));
+}
+
+static void queueCreate(LoadClient& client, const LoadOptions& options, uint32_t tag) {
+    NetCreate create = {static_cast<uint8_t>(NetMessage::CREATE), NET_SEAT_BOTH, static_cast<uint16_t>(options.rows),
+                        static_cast<uint16_t>(options.columns), 0, tag, 0, Rng::mix(options.seed, tag)};
+    queue(client, create);
+}
+
+static void queueAction(LoadClient& client, Rng& rng) {
+    NetMatchRef action = {static_cast<uint8_t>(NetMessage::ACTION), 0,
+                          gameActions[rng.nextBelow(GAME_ACTION_COUNT)], 0,
+                          client.matches[rng.nextBelow(client.matches.size())]};
+    queue(client, action);
+    client.inFlight.push_back(Clock::now());
+}
+
+// Handles every whole reply in the client's input
+static void handleReplies(LoadClient& client, const LoadOptions& options, LoadTotals& totals, uint32_t& nextTag) {
+    size_t used = 0;
+    while (used < client.input.size()) {
+        size_t length = netMessageSize(client.input[used]);
+        if (length == 0) {
+            std::cerr << "The server sent an unknown message" << std::endl;
+            std::exit(1);
+        }
+        if (client.input.size() - used < length) break;
+        const uint8_t* message = client.input.data() + used;
+        used += length;
+        switch (static_cast<NetMessage>(message[0])) {
+            case NetMessage::CREATED: {
+                NetMatchInfo info;
+                std::memcpy(&info, message, sizeof(info));
+                client.matches.push_back(info.match);
+                ++totals.created;
+                if (options.verify) {
+                    nodeMatrix board(info.rows, info.columns, info.seed);
+                    board.generateMaze(info.seed);
+                    totals.badBoards += board.getMazeChecksum() != info.mazeChecksum;
+                }
+                break;
+            }
+            case NetMessage::MOVED: {
+                NetMoved moved;
+                std::memcpy(&moved, message, sizeof(moved));
+                totals.latencies.push_back(std::chrono::duration<float, std::micro>(Clock::now() - client.inFlight.front()).count());
+                client.inFlight.pop_front();
+                ++totals.actions;
+                auto it = moved.winner < 0 ? client.matches.end() : std::find(client.matches.begin(), client.matches.end(), moved.match);
+                if (it != client.matches.end()) {
+                    // Leave the finished match and start another in its place
+                    *it = client.matches.back();
+                    client.matches.pop_back();
+                    queue(client, NetMatchRef{static_cast<uint8_t>(NetMessage::LEAVE), 0, 0, 0, moved.match});
+                    queueCreate(client, options, nextTag++);
+                    ++totals.finished;
+                }
+                break;
+            }
+            case NetMessage::ERROR: {
+                NetMatchRef error;
+                std::memcpy(&error, message, sizeof(error));
+                if (error.match == 0) {
+                    std::cerr << "The server refused a board of " << options.rows << "x" << options.columns << std::endl;
+                    std::exit(1);
+                }
+                // An action already on its way when its match finished
+                client.inFlight.pop_front();
+                ++totals.refused;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    client.input.erase(client.input.begin(), client.input.begin() + used);
+}
+
+static bool readClient(LoadClient& client) {
+    uint8_t buffer[64 * 1024];
+    while (true) {
+        ssize_t n = ::recv(client.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (n > 0) {
+            client.input.insert(client.input.end(), buffer, buffer + n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    LoadOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--verify") {
+            options.verify = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "usage: loadgen [--unix PATH | --port N] [--connections C] [--matches M] [--rows R] [--columns C]"
+                         " [--idle SECONDS] [--seconds S] [--window W] [--seed S] [--verify]" << std::endl;
+            return 1;
+        }
+        if (arg == "--unix") options.unixPath = argv[++i];
+        else if (arg == "--port") options.port = std::stoi(argv[++i]);
+        else if (arg == "--connections") options.connections = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--matches") options.matches = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--rows") options.rows = std::max(2, std::stoi(argv[++i]));
+        else if (arg == "--columns") options.columns = std::max(2, std::stoi(argv[++i]));
+        else if (arg == "--idle") options.idleSeconds = std::max(0.0, std::stod(argv[++i]));
+        else if (arg == "--seconds") options.seconds = std::max(0.0, std::stod(argv[++i]));
+        else if (arg == "--window") options.window = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--seed") options.seed = std::stoull(argv[++i]);
+    }
+    options.connections = std::min(options.connections, options.matches);
+    std::signal(SIGPIPE, SIG_IGN);
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    std::vector<LoadClient> clients(options.connections);
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    for (size_t c = 0; c < clients.size(); ++c) {
+        clients[c].fd = connectTo(options);
+        if (clients[c].fd < 0) {
+            std::cerr << "Cannot connect: " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        epoll_event event = {EPOLLIN, {}};
+        event.data.u64 = c;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, clients[c].fd, &event);
+    }
+
+    LoadTotals totals;
+    uint32_t nextTag = 0;
+    auto pump = [&](int timeoutMs) {
+        epoll_event events[256];
+        int count = epoll_wait(epollFd, events, 256, timeoutMs);
+        for (int i = 0; i < count; ++i) {
+            LoadClient& client = clients[events[i].data.u64];
+            if (!readClient(client)) {
+                std::cerr << "The server closed a connection" << std::endl;
+                std::exit(1);
+            }
+            handleReplies(client, options, totals, nextTag);
+        }
+    };
+
+    // Create every match, spread evenly over the connections
+    auto start = Clock::now();
+    for (int m = 0; m < options.matches; ++m) queueCreate(clients[m % clients.size()], options, nextTag++);
+    for (LoadClient& client : clients) flushClient(client);
+    while (totals.created < options.matches) pump(1000);
+    double createSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "created " << totals.created << " matches of " << options.rows << "x" << options.columns << " over "
+              << clients.size() << " connections in " << createSeconds << " s ("
+              << totals.created / createSeconds << " matches/sec)";
+    if (options.verify) std::cout << ", " << totals.badBoards << " boards differ from their seed";
+    std::cout << std::endl;
+
+    std::cout << "holding them idle for " << options.idleSeconds << " s" << std::endl;
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.idleSeconds));
+
+    // Play: keep window actions in flight on every connection
+    Rng rng(options.seed);
+    totals.latencies.clear();
+    totals.latencies.reserve(1 << 20);
+    start = Clock::now();
+    auto end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.seconds));
+    while (Clock::now() < end) {
+        for (LoadClient& client : clients) {
+            while (!client.matches.empty() && client.inFlight.size() < static_cast<size_t>(options.window)) {
+                queueAction(client, rng);
+            }
+            if (!client.output.empty() && !flushClient(client)) {
+                std::cerr << "The server closed a connection" << std::endl;
+                return 1;
+            }
+        }
+        pump(100);
+    }
+    double playSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::sort(totals.latencies.begin(), totals.latencies.end());
+    auto percentile = [&totals](double p) {
+        return totals.latencies.empty() ? 0.0f : totals.latencies[static_cast<size_t>(p * (totals.latencies.size() - 1))];
+    };
+    std::cout << "actions: " << totals.actions << "  actions/sec: " << totals.actions / playSeconds
+              << "  latency us p50: " << percentile(0.5) << "  p99: " << percentile(0.99)
+              << "  finished matches: " << totals.finished << "  refused: " << totals.refused << std::endl;
+    for (LoadClient& client : clients) ::close(client.fd);
+    return totals.badBoards ? 1 : 0;
+}
@@ -0,0 +1,333 @@
+// Match server: hosts many matches in one process for clients on a Unix
+// domain socket or localhost TCP, speaking MatchHost's NetMessage protocol.
+// A few worker threads each run an epoll loop over the connections the
+// acceptor deals them round-robin. Replies to a worker's own connections are
+// queued and written once per epoll batch; a reply to a connection of another
+// worker (the opponent's seat) is written straight away. Output a client does
+// not read is buffered up to SERVER_MAX_PENDING bytes, then it is dropped.
+//
+//   matchserver [--unix PATH | --port N] [--workers N] [--stats SECONDS]
+//
+// Defaults to TCP on 127.0.0.1:7878 with one worker per hardware thread
+// (at most 4), printing matches, connections, actions/s and memory every
+// 5 seconds. Linux only (epoll, eventfd).
+
+#include "../src/backend.h"
+#include <arpa/inet.h>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+const int SERVER_DEFAULT_PORT = 7878;
+const int SERVER_MAX_WORKERS = 4;
+const int SERVER_EPOLL_BATCH = 256;
+const size_t SERVER_READ_CHUNK = 64 * 1024;
+const size_t SERVER_MAX_PENDING = 16 * 1024 * 1024;
+
+struct ServerOptions {
+    std::string unixPath;
+    int port = SERVER_DEFAULT_PORT;
+    int workers = 0;
+    int statsSeconds = 5;
+};
+
+struct Worker;
+static std::vector<std::unique_ptr<Worker>> workers;
+static thread_local int currentWorker = -1;
+
+class Connection : public MatchClient {
+public:
+    int fd;
+    int worker;
+    std::vector<uint8_t> input;
+
+    Connection(int fd, int worker) : fd(fd), worker(worker) {}
+
+    void send(const void* message, size_t size) override;
+
+    // Writes what the socket takes; the rest waits for EPOLLOUT
+    void flush() {
+        std::lock_guard<std::mutex> guard(lock);
+        queued = false;
+        flushLocked();
+    }
+
+    // Stops all further output; the owning worker closes the socket
+    void shut() {
+        std::lock_guard<std::mutex> guard(lock);
+        open = false;
+        output.clear();
+    }
+
+    bool isOpen() {
+        std::lock_guard<std::mutex> guard(lock);
+        return open;
+    }
+
+private:
+    std::mutex lock;
+    std::vector<uint8_t> output;
+    size_t sent = 0;
+    bool open = true;
+    bool queued = false;       // In the owning worker's flush list
+    bool waitingWrite = false; // EPOLLOUT armed
+
+    void flushLocked();
+};
+
+struct Worker {
+    int index;
+    int epollFd;
+    int wakeFd;                // eventfd: new connections are waiting in incoming
+    std::mutex incomingLock;
+    std::vector<int> incoming;
+    std::unordered_map<Connection*, std::shared_ptr<Connection>> connections;
+    std::vector<Connection*> flushList;
+    std::vector<uint8_t> scratch = std::vector<uint8_t>(SERVER_READ_CHUNK);
+    std::thread thread;
+};
+
+void Connection::send(const void* message, size_t size) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!open) return;
+    const uint8_t* bytes = static_cast<const uint8_t*>(message);
+    output.insert(output.end(), bytes, bytes + size);
+    if (output.size() - sent > SERVER_MAX_PENDING) {
+        // A client that stops reading is cut off rather than buffered forever
+        open = false;
+        output.clear();
+        ::shutdown(fd, SHUT_RDWR);
+        return;
+    }
+    if (currentWorker != worker) {
+        flushLocked();
+    } else if (!queued) {
+        queued = true;
+        workers[worker]->flushList.push_back(this);
+    }
+}
+
+void Connection::flushLocked() {
+    while (open && sent < output.size()) {
+        ssize_t n = ::send(fd, output.data() + sent, output.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0) {
+            sent += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!waitingWrite) {
+                epoll_event event = {EPOLLIN | EPOLLOUT, {this}};
+                epoll_ctl(workers[worker]->epollFd, EPOLL_CTL_MOD, fd, &event);
+                waitingWrite = true;
+            }
+            return;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        open = false; // The reader sees the hang-up and closes the connection
+    }
+    output.clear();
+    sent = 0;
+    if (waitingWrite) {
+        epoll_event event = {EPOLLIN, {this}};
+        epoll_ctl(workers[worker]->epollFd, EPOLL_CTL_MOD, fd, &event);
+        waitingWrite = false;
+    }
+}
+
+static MatchHost host;
+static std::atomic<int64_t> connectionCount(0);
+
+static void closeConnection(Worker& worker, Connection* connection) {
+    auto it = worker.connections.find(connection);
+    if (it == worker.connections.end()) return;
+    std::shared_ptr<Connection> owned = it->second;
+    worker.connections.erase(it);
+    host.disconnect(owned);
+    owned->shut();
+    epoll_ctl(worker.epollFd, EPOLL_CTL_DEL, owned->fd, nullptr);
+    ::close(owned->fd);
+    --connectionCount;
+}
+
+// Reads everything available and feeds the whole messages to the host
+static void readConnection(Worker& worker, Connection* connection) {
+    std::shared_ptr<Connection> owned = worker.connections[connection];
+    bool closed = false;
+    while (true) {
+        ssize_t n = ::recv(owned->fd, worker.scratch.data(), worker.scratch.size(), MSG_DONTWAIT);
+        if (n > 0) {
+            owned->input.insert(owned->input.end(), worker.scratch.begin(), worker.scratch.begin() + n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        closed = n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+        break;
+    }
+    size_t used = host.consume(owned, owned->input.data(), owned->input.size());
+    if (used == NET_PROTOCOL_ERROR || closed || !owned->isOpen()) {
+        closeConnection(worker, connection);
+        return;
+    }
+    owned->input.erase(owned->input.begin(), owned->input.begin() + used);
+}
+
+static void adoptIncoming(Worker& worker) {
+    uint64_t count;
+    if (::read(worker.wakeFd, &count, sizeof(count)) < 0) return;
+    std::vector<int> fds;
+    {
+        std::lock_guard<std::mutex> guard(worker.incomingLock);
+        fds.swap(worker.incoming);
+    }
+    for (int fd : fds) {
+        auto connection = std::make_shared<Connection>(fd, worker.index);
+        worker.connections.emplace(connection.get(), connection);
+        epoll_event event = {EPOLLIN, {connection.get()}};
+        epoll_ctl(worker.epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+static void runWorker(Worker& worker) {
+    currentWorker = worker.index;
+    insideWorkerThread = true; // Board generation stays on this thread
+    epoll_event events[SERVER_EPOLL_BATCH];
+    while (true) {
+        int count = epoll_wait(worker.epollFd, events, SERVER_EPOLL_BATCH, -1);
+        for (int i = 0; i < count; ++i) {
+            Connection* connection = static_cast<Connection*>(events[i].data.ptr);
+            if (!connection) {
+                adoptIncoming(worker);
+                continue;
+            }
+            if (!worker.connections.count(connection)) continue; // Closed earlier in this batch
+            if (events[i].events & EPOLLOUT) connection->flush();
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) readConnection(worker, connection);
+        }
+        // Replies of the whole batch leave in one write per connection
+        for (Connection* connection : worker.flushList) {
+            if (worker.connections.count(connection)) connection->flush();
+        }
+        worker.flushList.clear();
+    }
+}
+
+static int listenOn(const ServerOptions& options) {
+    int fd;
+    if (!options.unixPath.empty()) {
+        fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, options.unixPath.c_str(), sizeof(address.sun_path) - 1);
+        ::unlink(options.unixPath.c_str());
+        if (fd < 0 || ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) return -1;
+    } else {
+        fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(options.port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (fd < 0 || ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) return -1;
+    }
+    return ::listen(fd, SOMAXCONN) < 0 ? -1 : fd;
+}
+
+// Resident memory in MB, from /proc
+static double residentMegabytes() {
+    long pages = 0, resident = 0;
+    if (FILE* statm = std::fopen("/proc/self/statm", "r")) {
+        if (std::fscanf(statm, "%ld %ld", &pages, &resident) != 2) resident = 0;
+        std::fclose(statm);
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1048576.0);
+}
+
+int main(int argc, char* argv[]) {
+    ServerOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "usage: matchserver [--unix PATH | --port N] [--workers N] [--stats SECONDS]" << std::endl;
+            return 1;
+        }
+        if (arg == "--unix") options.unixPath = argv[++i];
+        else if (arg == "--port") options.port = std::stoi(argv[++i]);
+        else if (arg == "--workers") options.workers = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--stats") options.statsSeconds = std::max(0, std::stoi(argv[++i]));
+    }
+    if (options.workers == 0) {
+        options.workers = std::min<int>(SERVER_MAX_WORKERS, std::max(1u, std::thread::hardware_concurrency()));
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // Every connection is a descriptor; take as many as the hard limit allows
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    int listener = listenOn(options);
+    if (listener < 0) {
+        std::cerr << "Cannot listen: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    for (int w = 0; w < options.workers; ++w) {
+        auto worker = std::make_unique<Worker>();
+        worker->index = w;
+        worker->epollFd = epoll_create1(EPOLL_CLOEXEC);
+        worker->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event event = {EPOLLIN, {nullptr}};
+        epoll_ctl(worker->epollFd, EPOLL_CTL_ADD, worker->wakeFd, &event);
+        workers.push_back(std::move(worker));
+    }
+    for (auto& worker : workers) worker->thread = std::thread(runWorker, std::ref(*worker));
+    std::cout << "Listening on " << (options.unixPath.empty() ? "127.0.0.1:" + std::to_string(options.port) : options.unixPath)
+              << " with " << options.workers << " workers" << std::endl;
+
+    // The acceptor deals connections out; stats come between accepts
+    int acceptEpoll = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event listenEvent = {EPOLLIN, {nullptr}};
+    epoll_ctl(acceptEpoll, EPOLL_CTL_ADD, listener, &listenEvent);
+    size_t next = 0;
+    uint64_t lastActions = 0;
+    auto lastStats = std::chrono::steady_clock::now();
+    while (true) {
+        epoll_event event;
+        int timeout = options.statsSeconds > 0 ? 250 : -1;
+        if (epoll_wait(acceptEpoll, &event, 1, timeout) > 0) {
+            int fd;
+            while ((fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                int on = 1;
+                if (options.unixPath.empty()) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+                Worker& worker = *workers[next++ % workers.size()];
+                {
+                    std::lock_guard<std::mutex> guard(worker.incomingLock);
+                    worker.incoming.push_back(fd);
+                }
+                uint64_t one = 1;
+                if (::write(worker.wakeFd, &one, sizeof(one)) < 0) std::cerr << "Cannot wake a worker" << std::endl;
+                ++connectionCount;
+            }
+        }
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - lastStats).count();
+        if (options.statsSeconds > 0 && seconds >= options.statsSeconds) {
+            uint64_t actions = host.getActionCount();
+            std::cout << "matches: " << host.getMatchCount() << "  connections: " << connectionCount
+                      << "  actions/sec: " << (actions - lastActions) / seconds
+                      << "  resident MB: " << residentMegabytes() << std::endl;
+            lastActions = actions;
+            lastStats = now;
+        }
+    }
+}
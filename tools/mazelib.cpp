@@ -0,0 +1,159 @@
+// Maze library builder: generates boards offline, scores their fairness and
+// writes them, distance maps included, to a maze library that the game and
+// the simulator load with --library. With --fair only boards that pass
+// analyzeFairness are kept. info lists a library, checks that every board
+// still loads and times a load against building the same board from its seed.
+//
+//   mazelib build FILE [--boards N] [--rows R] [--columns C] [--seed S]
+//                      [--braid P] [--threads T] [--fair]
+//   mazelib info FILE
+//
+// Exits with 1 when the library cannot be written or read, or a board no
+// longer loads.
+
+#include "../src/backend.h"
+#include <chrono>
+#include <cstring>
+
+struct BuildOptions {
+    long long boards = 256;
+    int rows = ::rows;
+    int columns = ::columns;
+    uint64_t seed = 1;
+    double braid = EXTRA_EDGE_PROB;
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    bool fairOnly = false;
+};
+
+struct BuiltBoard {
+    std::unique_ptr<nodeMatrix> matrix;
+    FairnessReport fairness;
+};
+
+// Builds a board the way the game does, with the maps the library stores
+void buildBoard(int rows, int columns, uint64_t seed, double braid, BuiltBoard& board) {
+    board.matrix = std::make_unique<nodeMatrix>(rows, columns, seed);
+    board.matrix->generateMaze(seed, braid);
+    if (!board.matrix->placeTreasure(true)) board.matrix->placeTreasure(false);
+    board.fairness = analyzeFairness(*board.matrix);
+    board.matrix->getDistanceField(DistanceSource::TREASURE);
+}
+
+int build(const std::string& path, const BuildOptions& options) {
+    MazeLibraryWriter writer;
+    if (!writer.open(path, options.rows, options.columns)) {
+        std::cerr << "Could not write " << path << std::endl;
+        return 1;
+    }
+    // Boards are built a batch at a time and added in seed order, so the
+    // library does not depend on the thread count
+    long long maxAttempts = options.fairOnly ? options.boards * BOARD_POOL_MAX_ATTEMPTS : options.boards;
+    long long attempts = 0;
+    std::vector<BuiltBoard> batch(static_cast<size_t>(options.threads) * 2);
+    auto start = std::chrono::steady_clock::now();
+    while (static_cast<long long>(writer.getBoardCount()) < options.boards && attempts < maxAttempts) {
+        long long count = std::min<long long>(static_cast<long long>(batch.size()), maxAttempts - attempts);
+        long long first = attempts;
+        workStealingFor(count, options.threads, options.seed, [&](int64_t i, int) {
+            buildBoard(options.rows, options.columns, Rng::mix(options.seed, static_cast<uint64_t>(first + i)), options.braid, batch[i]);
+        });
+        for (long long i = 0; i < count && static_cast<long long>(writer.getBoardCount()) < options.boards; ++i) {
+            if ((!options.fairOnly || batch[i].fairness.fair) && !writer.add(*batch[i].matrix, batch[i].fairness)) {
+                std::cerr << "Could not write " << path << std::endl;
+                return 1;
+            }
+            batch[i].matrix.reset();
+        }
+        attempts += count;
+    }
+    if (!writer.finish()) {
+        std::cerr << "Could not write " << path << std::endl;
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << path << ": " << writer.getBoardCount() << " boards of " << options.rows << "x" << options.columns
+              << " from " << attempts << " built  seconds: " << seconds << std::endl;
+    return 0;
+}
+
+int info(const std::string& path) {
+    MazeLibrary library;
+    if (!library.open(path)) {
+        std::cerr << path << ": not a maze library of version " << MAZE_LIBRARY_VERSION << std::endl;
+        return 1;
+    }
+    size_t boards = library.getBoardCount();
+    size_t fair = 0;
+    double score = 0;
+    for (size_t i = 0; i < boards; ++i) {
+        fair += library.getEntry(i).fair;
+        score += library.getEntry(i).fairnessScore;
+    }
+    std::cout << path << ": " << boards << " boards of " << library.getRows() << "x" << library.getColumns()
+              << "  fair: " << fair << "  mean fairness score: " << score / std::max<size_t>(1, boards) << std::endl;
+
+    // Every board through one reused matrix, as the simulator loads them
+    bool ok = true;
+    nodeMatrix matrix(library.getRows(), library.getColumns(), 0);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < boards; ++i) {
+        if (!library.load(i, matrix)) {
+            std::cerr << path << ": board " << i << " (seed " << library.getEntry(i).seed << ") does not match its checksum" << std::endl;
+            ok = false;
+        }
+    }
+    double loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t sampled = std::min<size_t>(boards, 16);
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < sampled; ++i) {
+        BuiltBoard board;
+        buildBoard(library.getRows(), library.getColumns(), library.getEntry(i).seed, library.getEntry(i).mazeBraid, board);
+    }
+    double buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (boards > 0) {
+        std::cout << "ms per board  load: " << 1000 * loadSeconds / boards
+                  << "  build from seed: " << 1000 * buildSeconds / sampled << std::endl;
+    }
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    const char* usage = "usage: mazelib build FILE [--boards N] [--rows R] [--columns C] [--seed S] [--braid P] "
+                        "[--threads T] [--fair]\n       mazelib info FILE";
+    if (argc < 3) {
+        std::cerr << usage << std::endl;
+        return 1;
+    }
+    std::string command = argv[1];
+    std::string path = argv[2];
+    if (command == "info" && argc == 3) return info(path);
+    if (command != "build") {
+        std::cerr << usage << std::endl;
+        return 1;
+    }
+    BuildOptions options;
+    for (int i = 3; i < argc; ++i) {
+        const char* flag = argv[i];
+        if (!std::strcmp(flag, "--fair")) {
+            options.fairOnly = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << usage << std::endl;
+            return 1;
+        }
+        const char* value = argv[++i];
+        if (!std::strcmp(flag, "--boards")) options.boards = std::max(1LL, std::stoll(value));
+        else if (!std::strcmp(flag, "--rows")) options.rows = std::max(2, std::stoi(value));
+        else if (!std::strcmp(flag, "--columns")) options.columns = std::max(2, std::stoi(value));
+        else if (!std::strcmp(flag, "--seed")) options.seed = std::stoull(value);
+        else if (!std::strcmp(flag, "--braid")) options.braid = std::stod(value);
+        else if (!std::strcmp(flag, "--threads")) options.threads = std::max(1, std::stoi(value));
+        else {
+            std::cerr << usage << std::endl;
+            return 1;
+        }
+    }
+    return build(path, options);
+}
@@ -0,0 +1,164 @@
+// Path query benchmark: shortest paths between random cell pairs with A*,
+// jump-point search and two breadth-first baselines (the word-frontier
+// DistanceField and a textbook queue BFS that stops at the target), on a
+// perfect maze, a braided maze, an open board and one with scattered walls.
+// Also counts heap allocations made during the timed PathFinder queries,
+// which should be zero.
+//
+//   pathbench [--rows R] [--columns C] [--queries N] [--seed S] [--portals N]
+//
+// --portals sets the number of portal pairs on every board (default 1).
+
+#include "../src/backend.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <new>
+
+static std::atomic<long long> allocations(0);
+
+__attribute__((noinline)) void* operator new(std::size_t size) {
+    ++allocations;
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+__attribute__((noinline)) void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+struct BenchOptions {
+    int rows = 200;
+    int columns = 200;
+    int queries = 2000;
+    uint64_t seed = 1;
+    int portalPairs = DEFAULT_PORTAL_PAIRS;
+};
+
+// Reference search: a fresh distance vector and queue per query, as a
+// straightforward implementation would do it. Portal hops are free, so it is
+// a 0-1 BFS: their exits go to the front of the deque.
+int queueSearch(const MazeView& view, int64_t source, int64_t target) {
+    std::vector<int> distance(static_cast<size_t>(view.rows) * view.columns, -1);
+    std::deque<int64_t> frontier;
+    distance[source] = 0;
+    frontier.push_back(source);
+    while (!frontier.empty()) {
+        int64_t cell = frontier.front();
+        frontier.pop_front();
+        if (cell == target) return distance[cell];
+        int row = static_cast<int>(cell / view.columns);
+        int column = static_cast<int>(cell % view.columns);
+        for (int d = 0; d < directionSize; ++d) {
+            Direction direction = static_cast<Direction>(d);
+            if (!view.canMove(row, column, direction)) continue;
+            int nextRow = row, nextColumn = column;
+            nodeMatrix::step(nextRow, nextColumn, direction);
+            int64_t next = static_cast<int64_t>(nextRow) * view.columns + nextColumn;
+            if (distance[next] < 0 || distance[next] > distance[cell] + 1) {
+                distance[next] = distance[cell] + 1;
+                frontier.push_back(next);
+            }
+        }
+        int64_t partner = view.portalPartner(cell);
+        if (partner >= 0 && (distance[partner] < 0 || distance[partner] > distance[cell])) {
+            distance[partner] = distance[cell];
+            frontier.push_front(partner);
+        }
+    }
+    return -1;
+}
+
+template <typename Query>
+double timeQueries(const std::vector<std::pair<int64_t, int64_t>>& pairs, long long& checksum, Query query) {
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& [source, target] : pairs) checksum += query(source, target);
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / pairs.size();
+}
+
+void runBoard(const char* name, nodeMatrix& matrix, const BenchOptions& options) {
+    if (static_cast<int>(matrix.getPortals().size()) != options.portalPairs) matrix.spawnFeatures(options.portalPairs, 0);
+    MazeView view = matrix.getView();
+    Rng rng(options.seed);
+    std::vector<std::pair<int64_t, int64_t>> pairs(options.queries);
+    int64_t cells = static_cast<int64_t>(options.rows) * options.columns;
+    for (auto& pair : pairs) pair = {static_cast<int64_t>(rng.nextBelow(cells)), static_cast<int64_t>(rng.nextBelow(cells))};
+
+    PathFinder finder;
+    DistanceField field;
+    std::vector<int64_t> path;
+    long long checksums[4] = {};
+    size_t expanded[2] = {};
+    // One warm-up query sizes the reusable buffers; the caller owns the path
+    finder.find(view, pairs[0].first, pairs[0].second, &path);
+    path.reserve(cells);
+
+    long long allocationsBefore = allocations;
+    double astar = timeQueries(pairs, checksums[0], [&](int64_t s, int64_t t) {
+        int length = finder.find(view, s, t, &path);
+        expanded[0] += finder.getExpandedNodes();
+        return length;
+    });
+    double jumpPoint = timeQueries(pairs, checksums[1], [&](int64_t s, int64_t t) {
+        int length = finder.find(view, s, t, &path, true, 0, PathFinder::Method::JUMP_POINT);
+        expanded[1] += finder.getExpandedNodes();
+        return length;
+    });
+    long long finderAllocations = allocations - allocationsBefore;
+    double frontier = timeQueries(pairs, checksums[2], [&](int64_t s, int64_t t) {
+        field.compute(view, {s});
+        return field.getDistances()[t];
+    });
+    double queue = timeQueries(pairs, checksums[3], [&](int64_t s, int64_t t) { return queueSearch(view, s, t); });
+
+    bool agree = checksums[0] == checksums[1] && checksums[1] == checksums[2] && checksums[2] == checksums[3];
+    std::cout << name << ": " << options.rows << "x" << options.columns << "  queries: " << options.queries
+              << (agree ? "" : "  LENGTHS DIFFER") << "\n"
+              << "  A*          " << astar << " us/query  " << expanded[0] / pairs.size() << " nodes\n"
+              << "  jump point  " << jumpPoint << " us/query  " << expanded[1] / pairs.size() << " nodes\n"
+              << "  BFS field   " << frontier << " us/query\n"
+              << "  BFS queue   " << queue << " us/query\n"
+              << "  PathFinder allocations while timed: " << finderAllocations << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!std::strcmp(argv[i], "--rows")) options.rows = std::stoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--columns")) options.columns = std::stoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--queries")) options.queries = std::max(1, std::stoi(argv[i + 1]));
+        else if (!std::strcmp(argv[i], "--seed")) options.seed = std::stoull(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--portals")) options.portalPairs = std::max(0, std::stoi(argv[i + 1]));
+        else {
+            std::cerr << "usage: pathbench [--rows R] [--columns C] [--queries N] [--seed S] [--portals N]" << std::endl;
+            return 1;
+        }
+    }
+
+    nodeMatrix perfect(options.rows, options.columns, options.seed);
+    perfect.generateMaze(options.seed, 0.0);
+    runBoard("perfect maze", perfect, options);
+
+    nodeMatrix braided(options.rows, options.columns, options.seed);
+    braided.generateMaze(options.seed, 0.3);
+    runBoard("braided maze", braided, options);
+
+    nodeMatrix open(options.rows, options.columns, options.seed);
+    runBoard("open board", open, options);
+
+    // Open board with scattered wall segments, like a braided maze after many wall jumps
+    Rng rng(options.seed);
+    for (int i = 0; i < options.rows; ++i) {
+        for (int j = 0; j < options.columns; ++j) {
+            if (rng.chance(0.1)) open.setWall(i, j, Direction::RIGHT, true);
+            if (rng.chance(0.1)) open.setWall(i, j, Direction::DOWN, true);
+        }
+    }
+    runBoard("scattered walls", open, options);
+    return 0;
+}
@@ -0,0 +1,124 @@
+// Board rendering benchmarks on Google Benchmark. Frames are drawn by
+// UI_Board into a window-sized surface through SDL's software renderer, with
+// the dummy video driver, so no display or GPU is needed and results compare
+// across Linux machines. Run from src/ so the sprites load as in the game:
+//
+//   cd src && ../renderbench [--benchmark_out=../renderbench.json --benchmark_out_format=json]
+//
+// Each board size is drawn fitted to the window (the cached layer, or the
+// minimap on large boards) and at full cell size following a player (the
+// culled per-cell path). Player 1 steps back and forth between frames, so the
+// caches redraw the few cells that changed, as during a match.
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <benchmark/benchmark.h>
+#include <iostream>
+
+#include "UI_Board.h"
+#include "UI_Cell.h"
+#include "UI_ImageLoader.h"
+#include "UI_MAIN.h"
+#include "backend.h"
+using namespace std;
+
+const uint64_t RENDER_BENCH_SEED = 1;
+
+static SDL_Renderer* benchRenderer = nullptr;
+
+enum RenderView { VIEW_FIT, VIEW_FOLLOW };
+
+struct RenderScene {
+    nodeMatrix matrix;
+    Player player1;
+    Player player2;
+    UI_Camera camera;
+    pair<int, int> home;
+    pair<int, int> away;  // Neighbouring cell player 1 alternates with
+
+    RenderScene(int size, RenderView view)
+        : matrix(size, size, RENDER_BENCH_SEED),
+          player1("Player 1", matrix.getPlayer1Start(), PlayerTurn::PLAYER1),
+          player2("Player 2", matrix.getPlayer2Start(), PlayerTurn::PLAYER2) {
+        matrix.generateMaze(RENDER_BENCH_SEED);
+        matrix.placeTreasure(true);
+        home = player1.getCurrentPosition();
+        away = make_pair(home.first, home.second + 1 < size ? home.second + 1 : home.second - 1);
+        camera.setViewport(WINDOW_WIDTH, WINDOW_HEIGHT);
+        camera.setBoardSize(size, size);
+        camera.fitBoard();
+        if (view == VIEW_FOLLOW) {
+            camera.zoomAt(CELL_SIZE / camera.getCellPixels(), WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2);
+            camera.setFollowing(true);
+        }
+    }
+
+    void drawFrame(UI_Board& board, long long frame) {
+        player1.setCurrentPosition(frame % 2 ? away : home);
+        camera.follow(player1.getCurrentPosition().first, player1.getCurrentPosition().second);
+        SDL_SetRenderDrawColor(benchRenderer, 255, 255, 255, 255);
+        SDL_RenderClear(benchRenderer);
+        board.renderBoard(benchRenderer, matrix, player1, player2, camera);
+        SDL_RenderFlush(benchRenderer);
+    }
+};
+
+// Steady-state frames: the board caches are warm
+static void BM_RenderFrame(benchmark::State& state) {
+    RenderScene scene(static_cast<int>(state.range(0)), static_cast<RenderView>(state.range(1)));
+    UI_Board board;
+    long long frame = 0;
+    scene.drawFrame(board, frame++);
+    for (auto _ : state) scene.drawFrame(board, frame++);
+    board.releaseTextures();
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(state.range(1) == VIEW_FIT ? "fit" : "follow");
+}
+BENCHMARK(BM_RenderFrame)
+    ->ArgsProduct({{10, 40, 200, 1000}, {VIEW_FIT, VIEW_FOLLOW}})
+    ->Unit(benchmark::kMicrosecond);
+
+// The first frame after a new board or a lost render target: caches rebuilt
+static void BM_RenderFirstFrame(benchmark::State& state) {
+    RenderScene scene(static_cast<int>(state.range(0)), VIEW_FIT);
+    UI_Board board;
+    for (auto _ : state) {
+        board.invalidate();
+        scene.drawFrame(board, 0);
+    }
+    board.releaseTextures();
+}
+BENCHMARK(BM_RenderFirstFrame)->Arg(10)->Arg(40)->Arg(200)->Arg(1000)->Unit(benchmark::kMicrosecond);
+
+int main(int argc, char* argv[]) {
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        cerr << "SDL could not start the dummy video driver: " << SDL_GetError() << endl;
+        return 1;
+    }
+    IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG);
+    SDL_Surface* target = SDL_CreateRGBSurfaceWithFormat(0, WINDOW_WIDTH, WINDOW_HEIGHT, 32, SDL_PIXELFORMAT_RGBA32);
+    benchRenderer = target ? SDL_CreateSoftwareRenderer(target) : nullptr;
+    if (!benchRenderer) {
+        cerr << "No software renderer: " << SDL_GetError() << endl;
+        if (target) SDL_FreeSurface(target);
+        SDL_Quit();
+        return 1;
+    }
+    imageLoader.generatePathsForVector();
+    if (!imageLoader.loadImages(benchRenderer, imageLoader.imagePaths)) {
+        cerr << "Some sprites are missing; run from src/ to draw the boards as in the game" << endl;
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    imageLoader.releaseTextures();
+    SDL_DestroyRenderer(benchRenderer);
+    SDL_FreeSurface(target);
+    IMG_Quit();
+    SDL_Quit();
+    return 0;
+}
@@ -0,0 +1,74 @@
+// Headless replay player: rebuilds the board of each recorded match, plays
+// every action back through nodeMatrix::takeTurn and reports how the match
+// ended, whether playback still matches the recorded keyframes and how fast
+// it ran. With --seek N it also jumps to action N and prints the position.
+//
+//   replay [--seek N] [--events] FILE...
+//
+// Exits with 1 when a file cannot be read or its playback diverges.
+
+#include "../src/backend.h"
+#include <chrono>
+#include <cstring>
+
+int main(int argc, char* argv[]) {
+    long long seekTo = -1;
+    bool printEvents = false;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--seek") && i + 1 < argc) seekTo = std::stoll(argv[++i]);
+        else if (!std::strcmp(argv[i], "--events")) printEvents = true;
+        else paths.push_back(argv[i]);
+    }
+    if (paths.empty()) {
+        std::cerr << "usage: replay [--seek N] [--events] FILE..." << std::endl;
+        return 1;
+    }
+
+    bool ok = true;
+    long long totalActions = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const std::string& path : paths) {
+        Replay replay;
+        if (!replay.load(path)) {
+            std::cerr << path << ": not a replay of version " << REPLAY_VERSION << std::endl;
+            ok = false;
+            continue;
+        }
+        const ReplayHeader& header = replay.getHeader();
+        nodeMatrix matrix(header.rows, header.columns, header.seed);
+        if (!replay.setUpBoard(matrix)) {
+            std::cerr << path << ": seed " << header.seed << " no longer builds the recorded board" << std::endl;
+            ok = false;
+            continue;
+        }
+        Player player1("Player 1", matrix.getPlayer1Start(), PlayerTurn::PLAYER1);
+        Player player2("Player 2", matrix.getPlayer2Start(), PlayerTurn::PLAYER2);
+        ConsoleEventSink console(player1.getPlayerID(), player2.getPlayerID());
+        ReplayPlayer playback(replay, matrix, player1, player2);
+        while (playback.step()) {
+            if (printEvents) matrix.drainEvents(console);
+            else matrix.getEvents().clear();
+        }
+        totalActions += static_cast<long long>(replay.getActionCount());
+
+        const char* result = player1.getHasWon() ? "player 1 won" : player2.getHasWon() ? "player 2 won" : "unfinished";
+        std::cout << path << ": " << header.rows << "x" << header.columns << "  seed: " << header.seed
+                  << "  actions: " << replay.getActionCount() << "  " << result
+                  << (playback.hasDiverged() ? "  DIVERGED" : "") << "\n";
+        ok = ok && !playback.hasDiverged();
+
+        if (seekTo >= 0) {
+            playback.seek(static_cast<uint64_t>(seekTo));
+            std::cout << "  before action " << playback.getCursor() << ": player 1 at ("
+                      << player1.getCurrentPosition().first << ", " << player1.getCurrentPosition().second
+                      << "), player 2 at (" << player2.getCurrentPosition().first << ", "
+                      << player2.getCurrentPosition().second << "), player "
+                      << (playback.getToMove() == PlayerTurn::PLAYER1 ? 1 : 2) << " to move\n";
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "files: " << paths.size() << "  actions: " << totalActions << "  seconds: " << seconds
+              << "  actions/sec: " << totalActions / seconds << std::endl;
+    return ok ? 0 : 1;
+}
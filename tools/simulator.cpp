@@ -0,0 +1,413 @@
+// Headless batch simulator: plays complete games back to back through
+// nodeMatrix::takeTurn with scripted, random or MCTS players and no SDL, then
+// reports throughput. Every game is built from its own seed derived from
+// --seed, so a run is reproducible regardless of the thread count. MCTS
+// players are reseeded from the game seed at the start of every game, so they
+// are reproducible too when given an iteration limit and no time budget.
+//
+//   simulator [--games N] [--rows R] [--columns C] [--sizes RxC,...] [--threads T]
+//             [--policy greedy|random|mcts] [--opponent greedy|random|mcts]
+//             [--noise P] [--braid P,...] [--seed S]
+//             [--mcts-iterations N] [--mcts-ms M] [--mcts-threads T]
+//             [--portals N,...] [--powers N,...] [--record DIR] [--report FILE]
+//             [--library FILE]
+//
+// --policy is player 1, --opponent player 2 (the same as --policy unless given).
+// --record writes every game to DIR/game-<index>.mzr for tools/replay.
+// --library plays the boards of a maze library (tools/mazelib) in turn
+// instead of generating one per game; it sets the board size. Random moves
+// come from each game's own seed, so a board played twice is two games.
+//
+// Balance tuning: --sizes, --braid, --portals and --powers take comma
+// separated lists, and the run becomes a tournament over every combination,
+// --games games each. Configurations share game seeds, so they are compared
+// on the same draws. The report gives each one's win rates, first-player
+// edge and game length; --report also writes it as CSV. Chunks of games are
+// run on a work-stealing pool, so small and large boards mix freely.
+
+#include "../src/backend.h"
+#include <chrono>
+#include <cstring>
+
+enum class Policy { GREEDY, RANDOM, MCTS };
+
+struct SimulationOptions {
+    long long games = 100000;
+    int rows = ::rows;
+    int columns = ::columns;
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    Policy policy = Policy::GREEDY;
+    Policy opponent = Policy::GREEDY;
+    bool opponentGiven = false;
+    MctsOptions mcts;
+    double noise = 0.1;  // Chance that a greedy player makes a random move
+    double braid = EXTRA_EDGE_PROB;
+    int portalPairs = DEFAULT_PORTAL_PAIRS;
+    int powerPickups = DEFAULT_POWER_PICKUPS;
+    uint64_t seed = 1;
+    std::string recordDirectory;  // Empty: games are not recorded
+    std::string reportPath;       // Empty: no CSV report
+    std::string libraryPath;      // Empty: every game generates its board
+    const MazeLibrary* library = nullptr;
+
+    // Tournament sweeps; an empty list stands for the single value above
+    std::vector<std::pair<int, int>> sizes;
+    std::vector<double> braids;
+    std::vector<int> portalCounts;
+    std::vector<int> powerCounts;
+};
+
+const int EVENT_TYPE_COUNT = static_cast<int>(GameEventType::POWER_ACTIVATED) + 1;
+const char* eventNames[EVENT_TYPE_COUNT] = {"boundary", "wall", "invalid", "treasure", "teleport", "power found", "power used"};
+
+struct SimulationTotals {
+    long long games = 0;
+    long long moves = 0;
+    long long player1Wins = 0;
+    long long player2Wins = 0;
+    long long unfinished = 0;
+    long long finishedMoves = 0;        // Moves of won games, for their length
+    double finishedMovesSquared = 0;
+    long long events[EVENT_TYPE_COUNT] = {};
+    long long rollouts = 0;
+    double searchCoreSeconds = 0;  // Time spent in MCTS searches times their threads
+
+    void add(const SimulationTotals& other) {
+        games += other.games;
+        moves += other.moves;
+        player1Wins += other.player1Wins;
+        player2Wins += other.player2Wins;
+        unfinished += other.unfinished;
+        finishedMoves += other.finishedMoves;
+        finishedMovesSquared += other.finishedMovesSquared;
+        for (int i = 0; i < EVENT_TYPE_COUNT; ++i) events[i] += other.events[i];
+        rollouts += other.rollouts;
+        searchCoreSeconds += other.searchCoreSeconds;
+    }
+};
+
+const char moveKeys[directionSize] = {'W', 'D', 'S', 'A'}; // Indexed by Direction
+
+// Greedy players step to the open neighbour closest to the treasure; they
+// never use powers
+char chooseMove(nodeMatrix& matrix, const Player& player, const DistanceField& toTreasure,
+                Policy policy, const SimulationOptions& options, Rng& rng) {
+    if (policy == Policy::RANDOM || rng.chance(options.noise)) {
+        return moveKeys[rng.nextBelow(directionSize)];
+    }
+    const MoveTable& moves = matrix.getMoveTable();
+    int64_t cell = matrix.cellOf(player.getCurrentPosition());
+    int best = -1;
+    int bestDistance = 0;
+    for (int d = 0; d < directionSize; ++d) {
+        uint32_t entry = moves.open[static_cast<size_t>(cell) * directionSize + d];
+        if (entry & MoveTable::MOVE_BLOCKED) continue;
+        int distance = toTreasure.getDistances()[moves.landing(cell, d, entry)];
+        if (distance >= 0 && (best < 0 || distance < bestDistance)) {
+            best = d;
+            bestDistance = distance;
+        }
+    }
+    return best < 0 ? moveKeys[rng.nextBelow(directionSize)] : moveKeys[best];
+}
+
+// matrix is the worker's board, rebuilt in place for every game: reset and
+// generated, or overwritten by a library board without generating anything
+void playGame(const SimulationOptions& options, long long gameIndex, nodeMatrix& matrix, MctsPlayer& ai, SimulationTotals& totals) {
+    uint64_t seed = Rng::mix(options.seed, static_cast<uint64_t>(gameIndex));
+    ai.reseed(Rng::mix(seed, 1000));
+    ++totals.games;
+    if (options.library) {
+        size_t board = static_cast<size_t>(gameIndex) % options.library->getBoardCount();
+        if (!options.library->load(board, matrix) || matrix.cellOf(matrix.getTreasure().getPosition()) < 0) {
+            ++totals.unfinished;
+            return;
+        }
+    } else {
+        matrix.reset(options.rows, options.columns, seed);
+        matrix.generateMaze(seed, options.braid);
+        if (options.portalPairs != DEFAULT_PORTAL_PAIRS || options.powerPickups != DEFAULT_POWER_PICKUPS) {
+            matrix.spawnFeatures(options.portalPairs, options.powerPickups);
+        }
+        if (!matrix.placeTreasure(true) && !matrix.placeTreasure(false)) {
+            ++totals.unfinished;
+            return;
+        }
+    }
+
+    Player players[2] = {Player("Player 1", matrix.getPlayer1Start(), PlayerTurn::PLAYER1),
+                         Player("Player 2", matrix.getPlayer2Start(), PlayerTurn::PLAYER2)};
+    const DistanceField& toTreasure = matrix.getDistanceField(DistanceSource::TREASURE);
+    // Not the matrix's engine: a library board restores the same state on every load
+    Rng rng(Rng::mix(seed, 0x90));
+    auto countEvent = [&totals](const GameEvent& event) { ++totals.events[static_cast<int>(event.type)]; };
+    CallbackEventSink<decltype(countEvent)> eventCounter(countEvent);
+
+    // Random walkers need about cells^1.5 moves on an open board; cap well above that
+    long long cells = static_cast<long long>(options.rows) * options.columns;
+    long long maxMoves = 64 * cells + 1000;
+    ReplayRecorder recorder;
+    bool recording = !options.recordDirectory.empty();
+    if (recording) recorder.start(matrix, players[0], players[1], PlayerTurn::PLAYER1);
+    auto saveRecording = [&]() {
+        std::string path = options.recordDirectory + "/game-" + std::to_string(gameIndex) + ".mzr";
+        if (recording && !recorder.save(path)) std::cerr << "Could not write " << path << std::endl;
+    };
+    int turn = 0;
+    for (long long move = 0; move < maxMoves; ++move) {
+        Player& player = players[turn];
+        Policy policy = turn == 0 ? options.policy : options.opponent;
+        char action;
+        if (policy == Policy::MCTS) {
+            action = ai.chooseMove(matrix, player, players[1 - turn]);
+            totals.rollouts += ai.getStats().rollouts;
+            totals.searchCoreSeconds += ai.getStats().seconds * ai.getStats().threads;
+        } else {
+            action = chooseMove(matrix, player, toTreasure, policy, options, rng);
+        }
+        if (recording) recorder.record(action);
+        bool again = matrix.takeTurn(player, players[1 - turn], action);
+        matrix.drainEvents(eventCounter);
+        ++totals.moves;
+        // A controlled opponent can be walked onto the treasure too
+        if (players[0].getHasWon() || players[1].getHasWon()) {
+            ++(players[1].getHasWon() ? totals.player2Wins : totals.player1Wins);
+            totals.finishedMoves += move + 1;
+            totals.finishedMovesSquared += static_cast<double>(move + 1) * (move + 1);
+            saveRecording();
+            return;
+        }
+        if (!again) turn = 1 - turn;
+    }
+    ++totals.unfinished;
+    saveRecording();
+}
+
+bool parsePolicy(const char* name, Policy& policy) {
+    if (!std::strcmp(name, "greedy")) policy = Policy::GREEDY;
+    else if (!std::strcmp(name, "random")) policy = Policy::RANDOM;
+    else if (!std::strcmp(name, "mcts")) policy = Policy::MCTS;
+    else return false;
+    return true;
+}
+
+// Comma separated values, each read by parse
+template <typename Value, typename Parse>
+std::vector<Value> parseList(const std::string& text, Parse parse) {
+    std::vector<Value> values;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t comma = std::min(text.find(',', start), text.size());
+        values.push_back(parse(text.substr(start, comma - start)));
+        start = comma + 1;
+    }
+    return values;
+}
+
+std::pair<int, int> parseSize(const std::string& text) {
+    size_t x = text.find('x');
+    if (x == std::string::npos) return {std::stoi(text), std::stoi(text)};
+    return {std::stoi(text.substr(0, x)), std::stoi(text.substr(x + 1))};
+}
+
+bool parseOptions(int argc, char* argv[], SimulationOptions& options) {
+    // MCTS players default to a fixed iteration count on one thread, so
+    // simulations stay reproducible
+    options.mcts.budgetMs = 0;
+    options.mcts.iterations = 1000;
+    options.mcts.threads = 1;
+    for (int i = 1; i < argc; ++i) {
+        const char* flag = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) {
+            std::cerr << "Missing value for " << flag << std::endl;
+            return false;
+        }
+        ++i;
+        if (!std::strcmp(flag, "--games")) options.games = std::stoll(value);
+        else if (!std::strcmp(flag, "--rows")) options.rows = std::stoi(value);
+        else if (!std::strcmp(flag, "--columns")) options.columns = std::stoi(value);
+        else if (!std::strcmp(flag, "--threads")) options.threads = std::max(1, std::stoi(value));
+        else if (!std::strcmp(flag, "--noise")) options.noise = std::stod(value);
+        else if (!std::strcmp(flag, "--sizes")) options.sizes = parseList<std::pair<int, int>>(value, parseSize);
+        else if (!std::strcmp(flag, "--braid")) options.braids = parseList<double>(value, [](const std::string& v) { return std::stod(v); });
+        else if (!std::strcmp(flag, "--seed")) options.seed = std::stoull(value);
+        else if (!std::strcmp(flag, "--mcts-iterations")) options.mcts.iterations = std::stoll(value);
+        else if (!std::strcmp(flag, "--mcts-ms")) options.mcts.budgetMs = std::stoi(value);
+        else if (!std::strcmp(flag, "--mcts-threads")) options.mcts.threads = std::max(1, std::stoi(value));
+        else if (!std::strcmp(flag, "--portals")) options.portalCounts = parseList<int>(value, [](const std::string& v) { return std::max(0, std::stoi(v)); });
+        else if (!std::strcmp(flag, "--powers")) options.powerCounts = parseList<int>(value, [](const std::string& v) { return std::max(0, std::stoi(v)); });
+        else if (!std::strcmp(flag, "--record")) options.recordDirectory = value;
+        else if (!std::strcmp(flag, "--report")) options.reportPath = value;
+        else if (!std::strcmp(flag, "--library")) options.libraryPath = value;
+        else if (!std::strcmp(flag, "--policy") && parsePolicy(value, options.policy)) continue;
+        else if (!std::strcmp(flag, "--opponent") && parsePolicy(value, options.opponent)) options.opponentGiven = true;
+        else {
+            std::cerr << "Unknown option " << flag << " " << value << std::endl;
+            return false;
+        }
+    }
+    if (!options.opponentGiven) options.opponent = options.policy;
+    if (!options.libraryPath.empty() &&
+        (!options.sizes.empty() || !options.braids.empty() || !options.portalCounts.empty() || !options.powerCounts.empty())) {
+        std::cerr << "--library brings its own boards; it takes no --sizes, --braid, --portals or --powers" << std::endl;
+        return false;
+    }
+    if (options.sizes.empty()) options.sizes.push_back({options.rows, options.columns});
+    if (options.braids.empty()) options.braids.push_back(options.braid);
+    if (options.portalCounts.empty()) options.portalCounts.push_back(options.portalPairs);
+    if (options.powerCounts.empty()) options.powerCounts.push_back(options.powerPickups);
+    for (const auto& size : options.sizes) {
+        if (size.first <= 0 || size.second <= 0) return false;
+    }
+    return true;
+}
+
+// Every combination of the swept values, as options for a single configuration
+std::vector<SimulationOptions> tournamentConfigurations(const SimulationOptions& options) {
+    std::vector<SimulationOptions> configurations;
+    for (const auto& size : options.sizes) {
+        for (double braid : options.braids) {
+            for (int portals : options.portalCounts) {
+                for (int powers : options.powerCounts) {
+                    SimulationOptions configuration = options;
+                    configuration.rows = size.first;
+                    configuration.columns = size.second;
+                    configuration.braid = braid;
+                    configuration.portalPairs = portals;
+                    configuration.powerPickups = powers;
+                    configurations.push_back(configuration);
+                }
+            }
+        }
+    }
+    return configurations;
+}
+
+// Player 1's wins minus player 2's over finished games, with a 95% interval
+std::pair<double, double> firstPlayerEdge(const SimulationTotals& totals) {
+    long long finished = totals.player1Wins + totals.player2Wins;
+    if (finished == 0) return {0, 0};
+    double edge = static_cast<double>(totals.player1Wins - totals.player2Wins) / finished;
+    return {edge, 1.96 * std::sqrt(std::max(0.0, 1 - edge * edge) / finished)};
+}
+
+std::pair<double, double> gameLength(const SimulationTotals& totals) {
+    long long finished = totals.player1Wins + totals.player2Wins;
+    if (finished == 0) return {0, 0};
+    double mean = static_cast<double>(totals.finishedMoves) / finished;
+    return {mean, std::sqrt(std::max(0.0, totals.finishedMovesSquared / finished - mean * mean))};
+}
+
+void printTournament(const std::vector<SimulationOptions>& configurations, const std::vector<SimulationTotals>& results) {
+    std::printf("%-11s %6s %7s %6s %8s %7s %7s %10s %16s %14s\n", "board", "braid", "portals", "powers", "games",
+                "p1 win", "p2 win", "unfinished", "p1 edge (95%)", "moves (sd)");
+    for (size_t c = 0; c < configurations.size(); ++c) {
+        const SimulationOptions& configuration = configurations[c];
+        const SimulationTotals& totals = results[c];
+        std::string board = std::to_string(configuration.rows) + "x" + std::to_string(configuration.columns);
+        double games = std::max(1LL, totals.games);
+        auto edge = firstPlayerEdge(totals);
+        auto length = gameLength(totals);
+        std::printf("%-11s %6.2f %7d %6d %8lld %6.1f%% %6.1f%% %10lld %+7.3f +- %5.3f %7.1f (%5.1f)\n", board.c_str(),
+                    configuration.braid, configuration.portalPairs, configuration.powerPickups, totals.games,
+                    100 * totals.player1Wins / games, 100 * totals.player2Wins / games, totals.unfinished,
+                    edge.first, edge.second, length.first, length.second);
+    }
+}
+
+bool writeReport(const std::string& path, const std::vector<SimulationOptions>& configurations,
+                 const std::vector<SimulationTotals>& results) {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) return false;
+    std::fprintf(file, "rows,columns,braid,portals,powers,games,player1_wins,player2_wins,unfinished,"
+                       "first_player_edge,edge_ci95,mean_moves,sd_moves\n");
+    for (size_t c = 0; c < configurations.size(); ++c) {
+        const SimulationOptions& configuration = configurations[c];
+        const SimulationTotals& totals = results[c];
+        auto edge = firstPlayerEdge(totals);
+        auto length = gameLength(totals);
+        std::fprintf(file, "%d,%d,%g,%d,%d,%lld,%lld,%lld,%lld,%.5f,%.5f,%.3f,%.3f\n", configuration.rows,
+                     configuration.columns, configuration.braid, configuration.portalPairs, configuration.powerPickups,
+                     totals.games, totals.player1Wins, totals.player2Wins, totals.unfinished, edge.first, edge.second,
+                     length.first, length.second);
+    }
+    return std::fclose(file) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    SimulationOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "usage: simulator [--games N] [--rows R] [--columns C] [--sizes RxC,...] [--threads T] "
+                     "[--policy greedy|random|mcts] [--opponent greedy|random|mcts] [--noise P] [--braid P,...] [--seed S] "
+                     "[--mcts-iterations N] [--mcts-ms M] [--mcts-threads T] [--portals N,...] [--powers N,...] "
+                     "[--record DIR] [--report FILE] [--library FILE]" << std::endl;
+        return 1;
+    }
+    MazeLibrary library;
+    if (!options.libraryPath.empty()) {
+        if (!library.open(options.libraryPath) || library.getBoardCount() == 0) {
+            std::cerr << options.libraryPath << ": not a maze library of version " << MAZE_LIBRARY_VERSION
+                      << " with any boards" << std::endl;
+            return 1;
+        }
+        options.library = &library;
+        options.sizes = {{library.getRows(), library.getColumns()}};
+    }
+    std::vector<SimulationOptions> configurations = tournamentConfigurations(options);
+    size_t configurationCount = configurations.size();
+
+    // Each task is a chunk of one configuration's games; workers keep their
+    // own totals per configuration, their own board and their own MCTS
+    // player, which playGame reseeds from the game, so no result depends on
+    // the worker that ran it
+    const long long chunk = 64;
+    long long chunks = (options.games + chunk - 1) / chunk;
+    std::vector<SimulationTotals> perThread(static_cast<size_t>(options.threads) * configurationCount);
+    std::vector<std::unique_ptr<MctsPlayer>> ais(options.threads);
+    std::vector<std::unique_ptr<nodeMatrix>> boards(options.threads);
+    for (int t = 0; t < options.threads; ++t) {
+        ais[t] = std::make_unique<MctsPlayer>(options.mcts);
+        boards[t] = std::make_unique<nodeMatrix>(configurations[0].rows, configurations[0].columns, options.seed);
+    }
+    auto start = std::chrono::steady_clock::now();
+    workStealingFor(chunks * static_cast<long long>(configurationCount), options.threads, options.seed,
+                    [&](int64_t task, int worker) {
+        size_t c = static_cast<size_t>(task / chunks);
+        long long first = (task % chunks) * chunk;
+        long long last = std::min(first + chunk, options.games);
+        SimulationTotals& totals = perThread[static_cast<size_t>(worker) * configurationCount + c];
+        for (long long game = first; game < last; ++game) playGame(configurations[c], game, *boards[worker], *ais[worker], totals);
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<SimulationTotals> results(configurationCount);
+    SimulationTotals totals;
+    for (size_t i = 0; i < perThread.size(); ++i) {
+        results[i % configurationCount].add(perThread[i]);
+        totals.add(perThread[i]);
+    }
+    if (!options.reportPath.empty() && !writeReport(options.reportPath, configurations, results)) {
+        std::cerr << "Could not write " << options.reportPath << std::endl;
+    }
+
+    const char* policyNames[] = {"greedy", "random", "mcts"};
+    if (configurationCount > 1) std::cout << "configurations: " << configurationCount;
+    else std::cout << "board: " << configurations[0].rows << "x" << configurations[0].columns;
+    std::cout << "  policy: " << policyNames[static_cast<int>(options.policy)]
+              << " vs " << policyNames[static_cast<int>(options.opponent)]
+              << "  threads: " << options.threads << "\n"
+              << "games: " << totals.games << "  moves: " << totals.moves << "  seconds: " << seconds << "\n"
+              << "games/sec: " << totals.games / seconds << "  moves/sec: " << totals.moves / seconds << "\n"
+              << "player 1 wins: " << totals.player1Wins << "  player 2 wins: " << totals.player2Wins
+              << "  unfinished: " << totals.unfinished << "\n"
+              << "events:";
+    for (int i = 0; i < EVENT_TYPE_COUNT; ++i) std::cout << "  " << eventNames[i] << " " << totals.events[i];
+    std::cout << std::endl;
+    if (totals.rollouts > 0) {
+        std::cout << "mcts rollouts: " << totals.rollouts
+                  << "  rollouts/sec per core: " << totals.rollouts / totals.searchCoreSeconds << std::endl;
+    }
+    if (configurationCount > 1) printTournament(configurations, results);
+    return 0;
+}